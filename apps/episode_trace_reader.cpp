@@ -0,0 +1,126 @@
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <string>
+
+#include "tetris_env/EpisodeTrace.hpp"
+#include "tetris_env/TreeDump.hpp"
+
+namespace {
+
+namespace tr = tetris_env::trace;
+
+struct ReaderOptions {
+    std::string path;
+    std::optional<std::uint32_t> episode{};
+    bool steps = false;
+};
+
+void printUsage() {
+    std::cout << "Uso: episode_trace_reader <run.ttrace> [--episode E] [--steps]\n"
+              << "- Le o trace gravado com episode_trace no batch e imprime, por episodio, a seed das\n"
+              << "  pecas, as jogadas, o score final e o tamanho em bytes por jogada.\n"
+              << "- --steps lista cada jogada (peca, acao, linhas, score, latencia e hash do tabuleiro).\n";
+}
+
+std::optional<ReaderOptions> parseArgs(int argc, char** argv) {
+    ReaderOptions options{};
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            return std::nullopt;
+        } else if (arg == "--episode") {
+            if (i + 1 >= argc) {
+                std::cerr << "Erro: --episode precisa de um valor\n";
+                return std::nullopt;
+            }
+            options.episode = static_cast<std::uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--steps") {
+            options.steps = true;
+        } else if (options.path.empty()) {
+            options.path = arg;
+        } else {
+            std::cerr << "Erro: argumento desconhecido " << arg << '\n';
+            return std::nullopt;
+        }
+    }
+    if (options.path.empty()) {
+        return std::nullopt;
+    }
+    return options;
+}
+
+void printSteps(const tr::EpisodeRecord& record, bool hasBoardHash) {
+    long long score = 0;
+    for (std::size_t i = 0; i < record.steps.size(); ++i) {
+        const tr::StepRecord& step = record.steps[i];
+        const Action action = tetris_env::treedump::unpackAction(step.action);
+        score += step.scoreDelta;
+        std::cout << "  " << i + 1 << ": peca=" << static_cast<int>(step.piece) << " r" << action.rotation << " x"
+                  << action.targetX << (action.useHold ? " hold" : "")
+                  << " linhas=" << static_cast<int>(step.linesCleared) << " score=" << score << " (+"
+                  << step.scoreDelta << ") latencia=" << step.latencyUs << "us";
+        if (hasBoardHash) {
+            std::cout << " hash=" << std::hex << step.boardHash << std::dec;
+        }
+        std::cout << '\n';
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const auto options = parseArgs(argc, argv);
+    if (!options.has_value()) {
+        printUsage();
+        return 1;
+    }
+
+    std::ifstream in(options->path, std::ios::binary);
+    if (!in.is_open()) {
+        std::cerr << "Erro: nao foi possivel abrir " << options->path << '\n';
+        return 1;
+    }
+    std::uint32_t flags = 0;
+    if (!tr::readHeader(in, flags)) {
+        std::cerr << "Erro: " << options->path << " nao e um trace de episodios valido\n";
+        return 1;
+    }
+    const bool hasBoardHash = (flags & tr::kFlagBoardHash) != 0;
+    if ((flags & tr::kFlagFixedPieceStream) != 0) {
+        std::cout << "pecas em sequencia fixa (paired_seed): reproduzir com TetrisEnv::resetFixedStream(seed)\n";
+    }
+
+    tr::EpisodeRecord record;
+    std::size_t episodes = 0;
+    std::size_t totalSteps = 0;
+    std::streamoff start = in.tellg();
+    while (in.peek() != std::ifstream::traits_type::eof()) {
+        if (!tr::readEpisode(in, hasBoardHash, record)) {
+            std::cerr << "Aviso: episodio truncado ou corrompido no fim do arquivo\n";
+            break;
+        }
+        const std::streamoff end = in.tellg();
+        const std::streamoff bytes = end - start;
+        start = end;
+        ++episodes;
+        totalSteps += record.steps.size();
+        if (options->episode.has_value() && record.episode != *options->episode) {
+            continue;
+        }
+        std::cout << "episodio " << record.episode << " seed=" << record.seed << " jogadas=" << record.steps.size()
+                  << " score=" << record.finalScore << " bytes=" << bytes << " bytes/jogada="
+                  << (record.steps.empty() ? 0.0 : static_cast<double>(bytes) / static_cast<double>(record.steps.size()))
+                  << '\n';
+        if (options->steps) {
+            printSteps(record, hasBoardHash);
+        }
+    }
+    std::cout << episodes << " episodio(s), " << totalSteps << " jogada(s)";
+    if (totalSteps > 0) {
+        std::cout << ", " << static_cast<double>(start) / static_cast<double>(totalSteps) << " bytes/jogada no arquivo";
+    }
+    std::cout << '\n';
+    return 0;
+}
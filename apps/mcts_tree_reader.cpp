@@ -0,0 +1,211 @@
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "tetris_env/TreeDump.hpp"
+
+namespace {
+
+namespace td = tetris_env::treedump;
+
+struct ReaderOptions {
+    std::string path;
+    std::optional<std::uint32_t> episode{};
+    std::optional<std::uint32_t> move{};
+    int rootChildren = 5;
+    bool boards = false;
+};
+
+void printUsage() {
+    std::cout << "Uso: mcts_tree_reader <dump.bin> [--episode E] [--move M] [--top N] [--boards]\n"
+              << "- Le o dump gravado com tree_dump_file e imprime, por jogada, os filhos mais visitados\n"
+              << "  da raiz (somados entre os workers) e a variacao principal de cada worker.\n"
+              << "- --boards mostra o tabuleiro no fim de cada variacao (dump gravado com tree_dump_boards).\n";
+}
+
+std::optional<ReaderOptions> parseArgs(int argc, char** argv) {
+    ReaderOptions options{};
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto nextValue = [&]() -> std::optional<std::string> {
+            if (i + 1 >= argc) {
+                std::cerr << "Erro: " << arg << " precisa de um valor\n";
+                return std::nullopt;
+            }
+            return std::string(argv[++i]);
+        };
+        if (arg == "--help" || arg == "-h") {
+            return std::nullopt;
+        } else if (arg == "--episode" || arg == "--move" || arg == "--top") {
+            const auto value = nextValue();
+            if (!value.has_value()) {
+                return std::nullopt;
+            }
+            const int parsed = std::stoi(*value);
+            if (arg == "--episode") {
+                options.episode = static_cast<std::uint32_t>(parsed);
+            } else if (arg == "--move") {
+                options.move = static_cast<std::uint32_t>(parsed);
+            } else {
+                options.rootChildren = std::max(1, parsed);
+            }
+        } else if (arg == "--boards") {
+            options.boards = true;
+        } else if (options.path.empty()) {
+            options.path = arg;
+        } else {
+            std::cerr << "Erro: argumento desconhecido " << arg << '\n';
+            return std::nullopt;
+        }
+    }
+    if (options.path.empty()) {
+        return std::nullopt;
+    }
+    return options;
+}
+
+std::string formatAction(std::uint8_t packed) {
+    if (packed == td::kNoAction) {
+        return "raiz";
+    }
+    const Action action = td::unpackAction(packed);
+    std::string text = "r";
+    text += std::to_string(action.rotation);
+    text += " x";
+    text += std::to_string(action.targetX);
+    if (action.useHold) {
+        text += " hold";
+    }
+    return text;
+}
+
+// Filhos de cada no a partir da pre-ordem com a quantidade de filhos gravada.
+std::vector<std::vector<std::size_t>> buildChildren(const std::vector<td::NodeRecord>& nodes) {
+    std::vector<std::vector<std::size_t>> children(nodes.size());
+    std::vector<std::pair<std::size_t, int>> open; // (no, filhos ainda por ler)
+    for (std::size_t i = 0; i < nodes.size(); ++i) {
+        while (!open.empty() && open.back().second == 0) {
+            open.pop_back();
+        }
+        if (!open.empty()) {
+            children[open.back().first].push_back(i);
+            --open.back().second;
+        }
+        open.emplace_back(i, nodes[i].childCount);
+    }
+    return children;
+}
+
+void printBoard(const tetris_env::bitboard::Rows& rows) {
+    for (std::uint16_t bits : rows) {
+        if (bits == 0) {
+            continue;
+        }
+        std::cout << "        |";
+        for (int x = 0; x < tetris_env::bitboard::kWidth; ++x) {
+            std::cout << (((bits >> x) & 1u) != 0 ? '#' : '.');
+        }
+        std::cout << "|\n";
+    }
+}
+
+void printMove(const td::MoveRecord& record, const ReaderOptions& options, bool hasBoards) {
+    std::cout << "episodio " << record.episode << " jogada " << record.move
+              << " escolhida=" << formatAction(record.chosenAction) << '\n';
+
+    // Filhos da raiz somados entre os workers (a decisao do agente usa essas somas).
+    std::map<std::uint8_t, std::pair<long long, double>> rootStats;
+    for (const auto& nodes : record.workers) {
+        if (nodes.empty()) {
+            continue;
+        }
+        const auto children = buildChildren(nodes);
+        for (std::size_t child : children.front()) {
+            auto& [visits, total] = rootStats[nodes[child].action];
+            visits += nodes[child].visits;
+            total += static_cast<double>(nodes[child].meanValue) * nodes[child].visits;
+        }
+    }
+    std::vector<std::tuple<long long, double, std::uint8_t>> ranked;
+    for (const auto& [action, stats] : rootStats) {
+        ranked.emplace_back(stats.first, stats.first > 0 ? stats.second / static_cast<double>(stats.first) : 0.0, action);
+    }
+    std::sort(ranked.begin(), ranked.end(), [](const auto& a, const auto& b) { return std::get<0>(a) > std::get<0>(b); });
+    if (ranked.size() > static_cast<std::size_t>(options.rootChildren)) {
+        ranked.resize(static_cast<std::size_t>(options.rootChildren));
+    }
+    for (const auto& [visits, mean, action] : ranked) {
+        std::cout << "  " << std::left << std::setw(12) << formatAction(action) << std::right
+                  << " visitas=" << visits << " media=" << mean << '\n';
+    }
+
+    for (std::size_t w = 0; w < record.workers.size(); ++w) {
+        const auto& nodes = record.workers[w];
+        if (nodes.empty()) {
+            continue;
+        }
+        const auto children = buildChildren(nodes);
+        std::cout << "  worker " << w << " (" << nodes[0].visits << " visitas) pv:";
+        std::size_t current = 0;
+        while (!children[current].empty()) {
+            current = *std::max_element(children[current].begin(), children[current].end(),
+                                        [&](std::size_t a, std::size_t b) { return nodes[a].visits < nodes[b].visits; });
+            std::cout << " [" << formatAction(nodes[current].action) << " n=" << nodes[current].visits
+                      << " q=" << nodes[current].meanValue << ']';
+        }
+        std::cout << '\n';
+        if (options.boards && hasBoards) {
+            printBoard(nodes[current].board);
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const auto options = parseArgs(argc, argv);
+    if (!options.has_value()) {
+        printUsage();
+        return 1;
+    }
+
+    std::ifstream in(options->path, std::ios::binary);
+    if (!in.is_open()) {
+        std::cerr << "Erro: nao foi possivel abrir " << options->path << '\n';
+        return 1;
+    }
+    std::uint32_t flags = 0;
+    if (!td::readHeader(in, flags)) {
+        std::cerr << "Erro: " << options->path << " nao e um dump de arvore valido\n";
+        return 1;
+    }
+    const bool hasBoards = (flags & td::kFlagBoards) != 0;
+    if (options->boards && !hasBoards) {
+        std::cerr << "Aviso: dump gravado sem tabuleiros (tree_dump_boards)\n";
+    }
+
+    td::MoveRecord record;
+    int printed = 0;
+    while (in.peek() != std::ifstream::traits_type::eof()) {
+        if (!td::readMove(in, hasBoards, record)) {
+            std::cerr << "Aviso: registro truncado ou corrompido no fim do arquivo\n";
+            break;
+        }
+        if ((options->episode.has_value() && record.episode != *options->episode) ||
+            (options->move.has_value() && record.move != *options->move)) {
+            continue;
+        }
+        printMove(record, *options, hasBoards);
+        ++printed;
+    }
+    std::cout << printed << " jogada(s)\n";
+    return 0;
+}
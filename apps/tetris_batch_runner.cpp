@@ -1,34 +1,74 @@
 #include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <condition_variable>
 #include <cctype>
+#include <cstdint>
 #include <filesystem>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <optional>
+#include <random>
+#include <sstream>
 #include <string>
 #include <thread>
+#include <utility>
 #include <vector>
 
 #include "tetris_env/Agent.hpp"
+#include "tetris_env/EpisodeTrace.hpp"
 #include "tetris_env/GreedyAgent.hpp"
 #include "tetris_env/MctsConfig.hpp"
+#include "tetris_env/MoveLatency.hpp"
 #include "tetris_env/RandomAgent.hpp"
 #include "tetris_env/RunLogging.hpp"
+#include "tetris_env/RunResume.hpp"
+#include "tetris_env/RunWriter.hpp"
 #include "tetris_env/TetrisEnv.hpp"
 #include "tetris_env/MctsRolloutAgent.hpp"
+#include "tetris_env/TreeDump.hpp"
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 struct AgentBatchConfig {
     std::string name;
     std::string type;
     int episodes = 0;
     std::optional<std::string> mctsConfigPath;
+    std::optional<int> searchThreads; // fixa as threads de busca por jogo MCTS (sem calibracao)
+
+    // Parada antecipada: encerra o agente quando o IC95 da media do score fica mais estreito que
+    // stopCiHalfWidth ou quando a diferenca para o agente baseline fica decidida.
+    std::optional<double> stopCiHalfWidth;
+    std::optional<std::string> baseline;
+    int minEpisodes = 10;
+
+    // Varredura (sweep_<chave>: [v1, v2, ...]): o agente vira um agente por combinacao de valores.
+    std::vector<std::pair<std::string, std::vector<std::string>>> sweep;
+    std::vector<std::pair<std::string, std::string>> mctsOverrides; // aplicados sobre o mcts_config
 };
 
 struct BatchConfig {
     std::filesystem::path baseDir{};
     int threads = 0;
+    double calibrationSeconds = 1.0; // por divisao medida; 0 desliga a calibracao
+    bool columnarOutput = false;     // grava tambem o .tcol de cada CSV
+    // Avaliacao pareada (numeros aleatorios comuns): o episodio i de todos os agentes joga a
+    // sequencia de pecas da seed pairedSeed+i, fixa (nao muda com o uso do hold).
+    std::optional<std::uint32_t> pairedSeed;
+    bool hasSweep = false; // imprime a tabela score x custo por jogada no fim
+    bool episodeTrace = false;          // grava o trace por jogada (.ttrace) de cada episodio
+    bool episodeTraceBoardHash = false; // inclui o hash do tabuleiro em cada jogada do trace
     std::vector<AgentBatchConfig> agents;
 };
 
@@ -58,6 +98,15 @@ bool tryParseInt(const std::string& value, int& out) {
     }
 }
 
+bool tryParseDouble(const std::string& value, double& out) {
+    try {
+        out = std::stod(value);
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
 std::string makeSafeSuffix(const std::string& name) {
     std::string safe;
     safe.reserve(name.size());
@@ -76,11 +125,68 @@ std::string makeSafeSuffix(const std::string& name) {
 
 bool isMctsType(const std::string& type);
 
+// "[a, b, c]" ou "a, b, c" -> {"a", "b", "c"}
+std::vector<std::string> splitList(const std::string& value) {
+    std::string inner = trim(value);
+    if (!inner.empty() && inner.front() == '[') {
+        inner.erase(0, 1);
+    }
+    if (!inner.empty() && inner.back() == ']') {
+        inner.pop_back();
+    }
+    std::vector<std::string> items;
+    std::stringstream ss(inner);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        item = trim(item);
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+bool isThreadsKey(const std::string& key) {
+    return key == "threads" || key == "num_threads";
+}
+
+// Produto cartesiano da varredura; a ultima chave varia mais rapido. Cada combinacao recebe o nome
+// <name>:<chave>=<valor>:... e as threads de busca varridas viram search_threads fixo.
+std::vector<AgentBatchConfig> expandSweep(const AgentBatchConfig& agent) {
+    std::vector<AgentBatchConfig> expanded{agent};
+    expanded.front().sweep.clear();
+    for (const auto& [key, values] : agent.sweep) {
+        std::vector<AgentBatchConfig> next;
+        next.reserve(expanded.size() * values.size());
+        for (const AgentBatchConfig& partial : expanded) {
+            for (const std::string& value : values) {
+                AgentBatchConfig combo = partial;
+                combo.name += ":" + key + "=" + value;
+                if (isThreadsKey(key)) {
+                    combo.searchThreads = std::stoi(value);
+                } else {
+                    combo.mctsOverrides.emplace_back(key, value);
+                }
+                next.push_back(std::move(combo));
+            }
+        }
+        expanded = std::move(next);
+    }
+    return expanded;
+}
+
 void printUsage() {
-    std::cout << "Uso: tetris_batch_runner [caminho_config_yaml]\n\n"
+    std::cout << "Uso: tetris_batch_runner [caminho_config_yaml] [--resume <run_id>] [--run-id <run_id>]\n"
+              << "                           [--threads N] [--workers N | --shard i/n | --merge <run_id>]\n\n"
               << "- Se nenhum caminho for informado, usa \"config/batch_runs.yaml\".\n"
+              << "- --resume retoma um batch interrompido com a mesma config: os episodios ja gravados\n"
+              << "  nos CSVs do run_id sao mantidos e so os que faltam rodam.\n"
+              << "- --shard i/n joga so os episodios e com (e-1) % n == i-1 e grava CSVs _shard<i>of<n>;\n"
+              << "  --merge junta os shards do run_id no CSV de cada agente. --workers N roda os N shards\n"
+              << "  em processos locais e faz o merge. --threads substitui 'threads' da config.\n"
               << "- O arquivo YAML deve ter o formato:\n\n"
               << "    threads: 4\n"
+              << "    calibration_seconds: 1\n"
               << "    agents:\n"
               << "      - name: random_baseline\n"
               << "        type: random\n"
@@ -106,8 +212,15 @@ void printUsage() {
               << "        mcts_config: agents/mcts_rollout/greedy_random_tt.yaml\n\n"
               << "- Os resultados de cada agente sao gravados em:\n"
               << "    agents/<agent_dir>/run_<runId>_<agent_name_sanitizado>.csv\n"
-              << "- Agentes MCTS rodam episodios de forma sequencial e usam o numero de\n"
-              << "  threads configurado para paralelizar o proprio jogo.\n";
+              << "- Episodios de todos os agentes rodam ao mesmo tempo, dividindo o orcamento\n"
+              << "  'threads' entre jogos em paralelo e threads de busca de cada jogo MCTS.\n"
+              << "- A divisao dos agentes MCTS e calibrada medindo jogadas/s por calibration_seconds\n"
+              << "  em cada opcao; search_threads no agente fixa o valor.\n"
+              << "- paired_seed: N faz o episodio i de todos os agentes jogar a mesma sequencia de pecas\n"
+              << "  (seed N+i, independente do hold) e imprime a comparacao pareada de cada agente com o\n"
+              << "  baseline (ou o primeiro agente).\n"
+              << "- sweep_<chave>: [v1, v2] num agente MCTS gera um agente por combinacao de valores e\n"
+              << "  imprime no fim a tabela score x custo por jogada com os pontos de Pareto.\n";
 }
 
 std::optional<BatchConfig> loadBatchConfig(const std::string& path) {
@@ -128,6 +241,57 @@ std::optional<BatchConfig> loadBatchConfig(const std::string& path) {
     std::string line;
     int lineNumber = 0;
 
+    auto applyAgentKey = [&](const std::string& key, const std::string& value) {
+        if (key == "name") {
+            currentAgent.name = value;
+        } else if (key == "type") {
+            currentAgent.type = value;
+        } else if (key == "episodes") {
+            int parsed = 0;
+            if (tryParseInt(value, parsed)) {
+                currentAgent.episodes = parsed;
+            }
+        } else if (key == "mcts_config") {
+            currentAgent.mctsConfigPath = value;
+        } else if (key == "search_threads") {
+            int parsed = 0;
+            if (tryParseInt(value, parsed) && parsed > 0) {
+                currentAgent.searchThreads = parsed;
+            }
+        } else if (key == "stop_ci_half_width") {
+            double parsed = 0.0;
+            if (tryParseDouble(value, parsed) && parsed > 0.0) {
+                currentAgent.stopCiHalfWidth = parsed;
+            } else {
+                std::cerr << "Aviso: 'stop_ci_half_width' deve ser > 0 na linha " << lineNumber << '\n';
+            }
+        } else if (key == "baseline") {
+            currentAgent.baseline = value;
+        } else if (key.rfind("sweep_", 0) == 0) {
+            const std::string param = key.substr(6);
+            std::vector<std::string> values;
+            for (const std::string& item : splitList(value)) {
+                MctsParams probe{};
+                if (tetris::applyMctsParam(param, item, probe)) {
+                    values.push_back(item);
+                } else {
+                    std::cerr << "Aviso: valor '" << item << "' invalido para '" << key << "' na linha "
+                              << lineNumber << "; ignorado\n";
+                }
+            }
+            if (!values.empty()) {
+                currentAgent.sweep.emplace_back(param, std::move(values));
+            }
+        } else if (key == "min_episodes") {
+            int parsed = 0;
+            if (tryParseInt(value, parsed) && parsed >= 2) {
+                currentAgent.minEpisodes = parsed;
+            } else {
+                std::cerr << "Aviso: 'min_episodes' deve ser >= 2 na linha " << lineNumber << '\n';
+            }
+        }
+    };
+
     auto flushCurrentAgent = [&](int currentLine) -> bool {
         if (!agentStarted) {
             return true;
@@ -153,7 +317,18 @@ std::optional<BatchConfig> loadBatchConfig(const std::string& path) {
                       << "' (linha " << currentLine << ").\n";
             return false;
         }
-        config.agents.push_back(currentAgent);
+        if (currentAgent.sweep.empty()) {
+            config.agents.push_back(currentAgent);
+        } else if (!isMctsType(currentAgent.type)) {
+            std::cerr << "Erro: varredura (sweep_*) so vale para agentes MCTS; agente '" << currentAgent.name
+                      << "' (linha " << currentLine << ").\n";
+            return false;
+        } else {
+            for (AgentBatchConfig& combo : expandSweep(currentAgent)) {
+                config.agents.push_back(std::move(combo));
+            }
+            config.hasSweep = true;
+        }
         agentStarted = false;
         currentAgent = AgentBatchConfig{};
         return true;
@@ -186,6 +361,57 @@ std::optional<BatchConfig> loadBatchConfig(const std::string& path) {
                 continue;
             }
 
+            if (line.rfind("calibration_seconds", 0) == 0) {
+                const auto colonPos = line.find(':');
+                if (colonPos != std::string::npos) {
+                    double parsed = config.calibrationSeconds;
+                    if (tryParseDouble(trim(line.substr(colonPos + 1)), parsed) && parsed >= 0.0) {
+                        config.calibrationSeconds = parsed;
+                    } else {
+                        std::cerr << "Aviso: nao foi possivel interpretar 'calibration_seconds' na linha "
+                                  << lineNumber << '\n';
+                    }
+                }
+                continue;
+            }
+
+            if (line.rfind("columnar_output", 0) == 0) {
+                const auto colonPos = line.find(':');
+                if (colonPos != std::string::npos) {
+                    const std::string value = trim(line.substr(colonPos + 1));
+                    config.columnarOutput = value == "true" || value == "1" || value == "yes";
+                }
+                continue;
+            }
+
+            if (line.rfind("episode_trace", 0) == 0) {
+                const auto colonPos = line.find(':');
+                if (colonPos != std::string::npos) {
+                    const std::string key = trim(line.substr(0, colonPos));
+                    const std::string value = trim(line.substr(colonPos + 1));
+                    const bool enabled = value == "true" || value == "1" || value == "yes";
+                    if (key == "episode_trace") {
+                        config.episodeTrace = enabled;
+                    } else if (key == "episode_trace_board_hash") {
+                        config.episodeTraceBoardHash = enabled;
+                    }
+                }
+                continue;
+            }
+
+            if (line.rfind("paired_seed", 0) == 0) {
+                const auto colonPos = line.find(':');
+                if (colonPos != std::string::npos) {
+                    int parsed = 0;
+                    if (tryParseInt(trim(line.substr(colonPos + 1)), parsed) && parsed >= 0) {
+                        config.pairedSeed = static_cast<std::uint32_t>(parsed);
+                    } else {
+                        std::cerr << "Aviso: 'paired_seed' deve ser um inteiro >= 0 na linha " << lineNumber << '\n';
+                    }
+                }
+                continue;
+            }
+
             if (line == "agents:") {
                 inAgentsSection = true;
                 continue;
@@ -207,20 +433,7 @@ std::optional<BatchConfig> loadBatchConfig(const std::string& path) {
             if (!afterDash.empty()) {
                 const auto colonPos = afterDash.find(':');
                 if (colonPos != std::string::npos) {
-                    const std::string key = trim(afterDash.substr(0, colonPos));
-                    const std::string value = trim(afterDash.substr(colonPos + 1));
-                    if (key == "name") {
-                        currentAgent.name = value;
-                    } else if (key == "type") {
-                        currentAgent.type = value;
-                    } else if (key == "episodes") {
-                        int parsed = 0;
-                        if (tryParseInt(value, parsed)) {
-                            currentAgent.episodes = parsed;
-                        }
-                    } else if (key == "mcts_config") {
-                        currentAgent.mctsConfigPath = value;
-                    }
+                    applyAgentKey(trim(afterDash.substr(0, colonPos)), trim(afterDash.substr(colonPos + 1)));
                 }
             }
             continue;
@@ -242,18 +455,7 @@ std::optional<BatchConfig> loadBatchConfig(const std::string& path) {
             continue;
         }
 
-        if (key == "name") {
-            currentAgent.name = value;
-        } else if (key == "type") {
-            currentAgent.type = value;
-        } else if (key == "episodes") {
-            int parsed = 0;
-            if (tryParseInt(value, parsed)) {
-                currentAgent.episodes = parsed;
-            }
-        } else if (key == "mcts_config") {
-            currentAgent.mctsConfigPath = value;
-        }
+        applyAgentKey(key, value);
     }
 
     if (!flushCurrentAgent(lineNumber)) {
@@ -270,6 +472,20 @@ std::optional<BatchConfig> loadBatchConfig(const std::string& path) {
         return std::nullopt;
     }
 
+    for (const auto& agent : config.agents) {
+        if (!agent.baseline.has_value()) {
+            continue;
+        }
+        const bool known = std::any_of(config.agents.begin(), config.agents.end(), [&](const AgentBatchConfig& other) {
+            return other.name == *agent.baseline && &other != &agent;
+        });
+        if (!known) {
+            std::cerr << "Erro: baseline '" << *agent.baseline << "' do agente '" << agent.name
+                      << "' nao e outro agente do batch.\n";
+            return std::nullopt;
+        }
+    }
+
     return config;
 }
 
@@ -336,239 +552,1173 @@ std::optional<std::filesystem::path> resolveMctsConfigForAgent(const AgentBatchC
     return tetris::findMctsConfigPath(agentDir);
 }
 
-bool runEpisodesForAgent(const AgentBatchConfig& agentCfg,
-                         unsigned int maxConcurrentThreads,
-                         const std::filesystem::path& configBaseDir) {
-    const std::string runId = tetris::makeRunIdTimestamp();
-    const std::string canonicalType = agentCfg.type == "mcts_rollout" ? "mcts_rollout" : agentCfg.type;
-    const std::string agentDir = agentDirForType(canonicalType);
-    const std::string agentFilenameSuffix = agentFilenameSuffixFor(agentCfg);
-    const bool isMctsAgent = isMctsType(canonicalType);
-    const unsigned int threadsForEpisodes = isMctsAgent
-        ? 1u
-        : std::max(1u, std::min(maxConcurrentThreads, static_cast<unsigned int>(agentCfg.episodes)));
-    const unsigned int mctsThreadBudget = isMctsAgent ? std::max(1u, maxConcurrentThreads) : 1u;
+// Media e variancia do score incrementais (Welford).
+struct ScoreStats {
+    int count = 0;
+    double mean = 0.0;
+    double m2 = 0.0;
+
+    void add(double value) {
+        ++count;
+        const double delta = value - mean;
+        mean += delta / count;
+        m2 += delta * (value - mean);
+    }
 
+    // Variancia da media (s^2 / n).
+    double meanVariance() const { return count > 1 ? m2 / (count - 1) / count : 0.0; }
+};
+
+// Execucao de um agente dentro do batch: config resolvida, plano de threads e resultados.
+struct AgentRun {
+    AgentBatchConfig cfg;
+    std::string runId;
+    std::string canonicalType;
+    std::string agentDir;
+    std::string filenameSuffix;
+    bool isMcts = false;
     std::optional<MctsParams> mctsParams{};
     std::string agentConfigString;
+    std::optional<std::uint32_t> pairedSeed; // seed base das pecas no modo pareado
+    std::optional<std::uint32_t> traceFlags; // com valor, grava o trace por jogada
+    int shardIndex = 0; // --shard i/n: este processo joga os episodios e com (e-1) % n == i-1
+    int shardCount = 1;
+
+    unsigned int searchThreads = 1; // threads de busca por episodio (fichas do orcamento global)
+    unsigned int maxConcurrent = 1; // episodios deste agente rodando ao mesmo tempo
+    std::string splitSource;        // "calibrado", "fixo" (search_threads) ou "estatico"
+    // Com TT persistente os episodios compartilham a mesma instancia do agente e rodam em sequencia.
+    std::unique_ptr<MctsRolloutAgent> persistentMcts;
+
+    // Protegidos pelo mutex do escalonador.
+    std::vector<int> pendingEpisodes; // em ordem; sem os ja concluidos num --resume
+    std::size_t nextPending = 0;
+    unsigned int running = 0;
+    std::uint64_t waitingSince = 0; // ordem de chegada na espera por fichas (0 = nao espera)
+
+    AgentRun* baseline = nullptr;
+    std::string stopReason; // vazio enquanto o agente roda todos os episodios
+    bool finished = false;
+
+    // Protegidos pelo mutex de log.
+    int resumedEpisodes = 0;
+    int completedEpisodes = 0;
+    std::vector<std::optional<tetris::EpisodeReport>> reports; // por episodio; vazio se nao jogado
+    ScoreStats scoreStats;
+    std::vector<double> moveLatenciesMs;
+};
 
-    if (isMctsAgent) {
-        const auto configPathOpt = resolveMctsConfigForAgent(agentCfg, configBaseDir, agentDir);
-        if (!configPathOpt.has_value()) {
-            std::cerr << "Erro: config do MCTS nao encontrada. Defina mcts_config ou crie agents/" << agentDir
-                      << "/config.yaml.\n";
-            return false;
-        }
+bool ownsEpisode(const AgentRun& run, int episode) {
+    return (episode - 1) % run.shardCount == run.shardIndex;
+}
 
-        std::filesystem::path configPath = *configPathOpt;
-        if (!std::filesystem::exists(configPath)) {
-            std::cerr << "Erro: caminho de config do MCTS nao existe: " << configPath << '\n';
-            return false;
+bool prepareAgentRun(const AgentBatchConfig& agentCfg,
+                     const std::filesystem::path& configBaseDir,
+                     const std::string& runId,
+                     AgentRun& run) {
+    run.cfg = agentCfg;
+    run.runId = runId;
+    run.canonicalType = agentCfg.type == "mcts_rollout" ? "mcts_rollout" : agentCfg.type;
+    run.agentDir = agentDirForType(run.canonicalType);
+    run.filenameSuffix = agentFilenameSuffixFor(agentCfg);
+    run.isMcts = isMctsType(run.canonicalType);
+    run.reports.resize(static_cast<std::size_t>(agentCfg.episodes));
+    for (int episode = 1; episode <= agentCfg.episodes; ++episode) {
+        if (ownsEpisode(run, episode)) {
+            run.pendingEpisodes.push_back(episode);
         }
+    }
 
-        MctsParams params{};
-        if (!tetris::loadMctsParamsFromYaml(configPath, params)) {
-            return false;
-        }
+    if (!run.isMcts) {
+        return true;
+    }
 
-        if (canonicalType == "mcts_default") {
-            params.rolloutPolicy = MctsRolloutPolicy::Random;
-            params.useTranspositionTable = false;
-        } else if (canonicalType == "mcts_transposition") {
-            params.rolloutPolicy = MctsRolloutPolicy::Greedy;
-            params.useTranspositionTable = true;
-        } else if (canonicalType == "mcts_greedy") {
-            params.rolloutPolicy = MctsRolloutPolicy::Greedy;
-            params.useTranspositionTable = false;
-        }
+    const auto configPathOpt = resolveMctsConfigForAgent(agentCfg, configBaseDir, run.agentDir);
+    if (!configPathOpt.has_value()) {
+        std::cerr << "Erro: config do MCTS nao encontrada. Defina mcts_config ou crie agents/" << run.agentDir
+                  << "/config.yaml.\n";
+        return false;
+    }
 
-        params.threads = static_cast<int>(mctsThreadBudget);
-        mctsParams = params;
-        agentConfigString = tetris::buildMctsConfigString(params);
+    std::filesystem::path configPath = *configPathOpt;
+    if (!std::filesystem::exists(configPath)) {
+        std::cerr << "Erro: caminho de config do MCTS nao existe: " << configPath << '\n';
+        return false;
+    }
 
-        std::cout << "Config MCTS carregada de " << configPath << " para tipo " << canonicalType << '\n';
+    MctsParams params{};
+    if (!tetris::loadMctsParamsFromYaml(configPath, params)) {
+        return false;
     }
 
-    std::vector<tetris::EpisodeReport> reports(static_cast<std::size_t>(agentCfg.episodes));
-    std::vector<std::thread> workers;
-    workers.reserve(std::min<unsigned int>(threadsForEpisodes, static_cast<unsigned int>(agentCfg.episodes)));
-    std::mutex logMutex;
-    std::atomic_bool success{true};
-    std::atomic<int> completedEpisodes{0};
+    if (run.canonicalType == "mcts_default") {
+        params.rolloutPolicy = MctsRolloutPolicy::Random;
+        params.useTranspositionTable = false;
+    } else if (run.canonicalType == "mcts_transposition") {
+        params.rolloutPolicy = MctsRolloutPolicy::Greedy;
+        params.useTranspositionTable = true;
+    } else if (run.canonicalType == "mcts_greedy") {
+        params.rolloutPolicy = MctsRolloutPolicy::Greedy;
+        params.useTranspositionTable = false;
+    }
+    for (const auto& [key, value] : agentCfg.mctsOverrides) {
+        tetris::applyMctsParam(key, value, params);
+    }
+    run.mctsParams = params;
 
-    const std::optional<MctsParams> paramsOpt = mctsParams;
-    const std::string agentNameCopy = agentCfg.name;
-    const std::string modeName = "HeadlessBatch";
-    const std::string runIdCopy = runId;
-    const std::string agentConfigCopy = agentConfigString;
-    const std::string agentTypeCopy = canonicalType;
-    const bool isMctsAgentCopy = isMctsAgent;
-    const int totalEpisodesCopy = agentCfg.episodes;
-    const unsigned int mctsThreadsCopy = mctsThreadBudget;
-    const std::optional<int> scoreLimitCopy = paramsOpt.has_value() ? paramsOpt->scoreLimit : std::nullopt;
-    const std::optional<double> timeLimitCopy = paramsOpt.has_value() ? paramsOpt->timeLimitSeconds : std::nullopt;
-
-    auto launchEpisode = [&](int episodeIndex) {
-        workers.emplace_back([&, episodeIndex]() {
-            TetrisEnv env{};
-            env.reset();
-
-            std::unique_ptr<Agent> agent;
-            if (agentTypeCopy == "random") {
-                agent = std::make_unique<RandomAgent>();
-            } else if (agentTypeCopy == "greedy") {
-                agent = std::make_unique<GreedyAgent>();
-            } else if (isMctsAgentCopy) {
-                if (!paramsOpt.has_value()) {
-                    std::lock_guard<std::mutex> lock(logMutex);
-                    std::cerr << "Erro interno: MCTS params nao carregados.\n";
-                    success.store(false, std::memory_order_relaxed);
-                    return;
-                }
-                MctsParams paramsCopy = *paramsOpt;
-                paramsCopy.threads = static_cast<int>(mctsThreadsCopy);
-                agent = std::make_unique<MctsRolloutAgent>(paramsCopy);
-            } else {
-                std::lock_guard<std::mutex> lock(logMutex);
-                std::cerr << "Tipo de agente desconhecido: " << agentTypeCopy << '\n';
-                success.store(false, std::memory_order_relaxed);
-                return;
+    std::cout << "Config MCTS carregada de " << configPath << " para tipo " << run.canonicalType << '\n';
+    if (params.deterministic && !run.pairedSeed.has_value()) {
+        std::cout << "Modo deterministico: pecas do episodio i com seed " << params.seed.value_or(0)
+                  << "+i; move_time_ms e time_limit_seconds ignorados.\n";
+    }
+    return true;
+}
+
+// --resume: o CSV do agente e o checkpoint. Cada episodio concluido vira uma linha assim que
+// termina; aqui as linhas validas sao recarregadas, o arquivo e regravado sem uma eventual linha
+// cortada pela interrupcao e so os episodios que faltam voltam para a fila.
+bool resumeAgentRun(AgentRun& run) {
+    tetris::ResumedRunFiles resumed;
+    if (!tetris::resumeRunFiles(tetris::runFilePath(run.runId, run.agentDir, run.filenameSuffix, ".csv"),
+                                tetris::runFilePath(run.runId, run.agentDir, run.filenameSuffix, "_telemetry.jsonl"),
+                                tetris::runFilePath(run.runId, run.agentDir, run.filenameSuffix, ".ttrace"),
+                                run.cfg.episodes,
+                                resumed)) {
+        return false;
+    }
+
+    for (std::size_t i = 0; i < resumed.reports.size(); ++i) {
+        if (resumed.reports[i].has_value()) {
+            run.scoreStats.add(static_cast<double>(resumed.reports[i]->score));
+            run.reports[i] = resumed.reports[i];
+            ++run.resumedEpisodes;
+        }
+    }
+    run.pendingEpisodes.clear();
+    for (const int episode : resumed.missingEpisodes) {
+        if (ownsEpisode(run, episode)) {
+            run.pendingEpisodes.push_back(episode);
+        }
+    }
+    run.completedEpisodes = run.resumedEpisodes;
+    return true;
+}
+
+bool sharesAgentAcrossEpisodes(const AgentRun& run) {
+    return run.mctsParams.has_value() && run.mctsParams->useTranspositionTable &&
+           run.mctsParams->ttPersistAcrossEpisodes;
+}
+
+// Mede jogadas/s com `episodes` jogos simultaneos de `searchThreads` threads de busca cada. Cada
+// jogo roda ate o prazo e termina a jogada em curso; a taxa usa o tempo ate o ultimo terminar.
+double measureSplit(const MctsParams& params, unsigned int searchThreads, unsigned int episodes, double seconds) {
+    MctsParams probeParams = params;
+    probeParams.threads = static_cast<int>(searchThreads);
+    probeParams.telemetry = false;
+    probeParams.treeDumpFile.clear();
+    probeParams.ttFile.clear();
+    probeParams.ttPersistAcrossEpisodes = false;
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                      std::chrono::duration<double>(seconds));
+    std::atomic<long long> moves{0};
+    auto probe = [&](unsigned int slot) {
+        MctsRolloutAgent agent(probeParams);
+        TetrisEnv env{};
+        env.reset(probeParams.seed.value_or(0) + slot);
+        agent.onEpisodeStart();
+        long long done = 0;
+        do {
+            if (env.isGameOver() ||
+                (probeParams.scoreLimit.has_value() && env.getScore() >= *probeParams.scoreLimit)) {
+                env.reset(probeParams.seed.value_or(0) + slot + static_cast<std::uint32_t>(done));
+                agent.onEpisodeStart();
             }
+            env.step(agent.chooseAction(env));
+            ++done;
+        } while (std::chrono::steady_clock::now() < deadline);
+        moves.fetch_add(done, std::memory_order_relaxed);
+    };
 
-            agent->onEpisodeStart();
-            const auto start = std::chrono::steady_clock::now();
-            std::string endReason = "game_over";
-            while (!env.isGameOver()) {
-                if (scoreLimitCopy.has_value() && env.getScore() >= *scoreLimitCopy) {
-                    endReason = "score_limit";
-                    break;
-                }
+    std::vector<std::thread> probes;
+    probes.reserve(episodes);
+    for (unsigned int slot = 0; slot < episodes; ++slot) {
+        probes.emplace_back(probe, slot);
+    }
+    for (auto& t : probes) {
+        t.join();
+    }
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return elapsed > 0.0 ? static_cast<double>(moves.load()) / elapsed : 0.0;
+}
 
-                if (timeLimitCopy.has_value()) {
-                    const double elapsedSeconds =
-                        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
-                    if (elapsedSeconds >= *timeLimitCopy) {
-                        endReason = "time_limit";
-                        break;
-                    }
-                }
+// Escolhe as threads de busca por jogo que maximizam jogadas/s do agente dentro da sua fatia do
+// orcamento, medindo cada divisao (1, 2, 4, ... threads por jogo) com a config real.
+unsigned int calibrateSearchThreads(const AgentRun& run, unsigned int share, unsigned int slots, double seconds) {
+    std::vector<unsigned int> candidates;
+    for (unsigned int t = 1; t <= share; t *= 2) {
+        candidates.push_back(t);
+    }
+    if (candidates.back() != share) {
+        candidates.push_back(share);
+    }
 
-                const Action action = agent->chooseAction(env);
-                const StepResult result = env.step(action);
-                if (result.done) {
-                    break;
+    unsigned int best = 1;
+    double bestRate = -1.0;
+    std::cout << "Calibrando agente '" << run.cfg.name << "' (" << seconds << "s por divisao, " << share
+              << " thread(s)):\n";
+    for (unsigned int t : candidates) {
+        const unsigned int episodes = std::max(1u, std::min(slots, share / t));
+        const double rate = measureSplit(*run.mctsParams, t, episodes, seconds);
+        std::cout << "  " << episodes << " jogo(s) x " << t << " thread(s): " << rate << " jogadas/s\n";
+        if (rate > bestRate) {
+            bestRate = rate;
+            best = t;
+        }
+    }
+    return best;
+}
+
+// Divide o orcamento entre paralelismo de episodios e de busca. Cada agente tem uma fatia
+// proporcional aos seus episodios; sem calibracao, episodios independentes (que escalam quase
+// linearmente) ficam com a fatia e a busca root-parallel so recebe as threads que sobram.
+void planBatch(std::vector<AgentRun>& runs, unsigned int budget, double calibrationSeconds) {
+    auto slotsFor = [](const AgentRun& run) {
+        const auto pending = static_cast<unsigned int>(run.pendingEpisodes.size());
+        return sharesAgentAcrossEpisodes(run) ? std::min(1u, pending) : pending;
+    };
+    unsigned int episodeSlots = 0;
+    for (const AgentRun& run : runs) {
+        episodeSlots += slotsFor(run);
+    }
+    episodeSlots = std::max(1u, episodeSlots);
+
+    // A mesma config MCTS so e calibrada uma vez.
+    std::map<std::string, unsigned int> calibrated;
+    for (AgentRun& run : runs) {
+        const unsigned int slots = std::max(1u, slotsFor(run));
+        const unsigned int share = std::clamp(static_cast<unsigned int>(
+                                                  static_cast<unsigned long long>(budget) * slots / episodeSlots),
+                                              1u, budget);
+        run.searchThreads = 1u;
+        run.splitSource = "estatico";
+        if (run.isMcts && run.cfg.searchThreads.has_value()) {
+            run.searchThreads = std::min(static_cast<unsigned int>(*run.cfg.searchThreads), budget);
+            run.splitSource = "fixo";
+        } else if (run.isMcts) {
+            run.searchThreads = std::max(1u, share / slots);
+            // Reprodutibilidade e orcamento por tempo dependem das threads da busca, nao so da vazao.
+            const bool calibratable = calibrationSeconds > 0.0 && share > 1 && !run.mctsParams->deterministic &&
+                                      run.mctsParams->moveTimeMs <= 0.0;
+            if (calibratable) {
+                MctsParams keyParams = *run.mctsParams;
+                keyParams.threads = 1;
+                const std::string key = tetris::buildMctsConfigString(keyParams) + " share=" +
+                                        std::to_string(share) + " slots=" + std::to_string(slots);
+                auto it = calibrated.find(key);
+                if (it == calibrated.end()) {
+                    it = calibrated.emplace(key, calibrateSearchThreads(run, share, slots, calibrationSeconds)).first;
                 }
+                run.searchThreads = it->second;
+                run.splitSource = "calibrado";
             }
-            const auto end = std::chrono::steady_clock::now();
-            agent->onEpisodeEnd();
-
-            tetris::EpisodeReport report{};
-            report.agentName = agentNameCopy;
-            report.modeName = modeName;
-            report.agentConfig = agentConfigCopy;
-            report.runId = runIdCopy;
-            report.episodeIndex = episodeIndex;
-            report.score = env.getScore();
-            report.totalLines = env.getTotalLinesCleared();
-            report.totalTurns = env.getTurnNumber();
-            report.holdsUsed = env.getHoldsUsed();
-            report.elapsedSeconds = std::chrono::duration<float>(end - start).count();
-            report.endReason = endReason;
-
-            reports[static_cast<std::size_t>(episodeIndex - 1)] = report;
-
-            {
-                std::lock_guard<std::mutex> lock(logMutex);
-                const int finished = completedEpisodes.fetch_add(1, std::memory_order_relaxed) + 1;
-                std::cout << "[Agente " << agentNameCopy << "] episodio " << episodeIndex
-                          << " concluido: score=" << report.score
-                          << " linhas=" << report.totalLines
-                          << " turns=" << report.totalTurns
-                          << " tempo=" << report.elapsedSeconds << "s";
-                if (endReason == "score_limit") {
-                    std::cout << " (encerrado por limite de score)";
-                } else if (endReason == "time_limit") {
-                    std::cout << " (encerrado por limite de tempo)";
-                }
-                if (isMctsAgentCopy) {
-                    const double progress = static_cast<double>(finished) * 100.0 /
-                                             static_cast<double>(std::max(1, totalEpisodesCopy));
-                    std::cout << " progresso=" << finished << '/' << totalEpisodesCopy
-                              << " (" << progress << "%)";
-                }
-                std::cout << '\n';
+        }
+
+        run.maxConcurrent = sharesAgentAcrossEpisodes(run)
+            ? 1u
+            : std::clamp(static_cast<unsigned int>(run.pendingEpisodes.size()), 1u, budget / run.searchThreads);
+        if (run.mctsParams.has_value()) {
+            run.mctsParams->threads = static_cast<int>(run.searchThreads);
+            run.agentConfigString = tetris::buildMctsConfigString(*run.mctsParams) + " split=" +
+                                    std::to_string(std::min(share / run.searchThreads, slots)) + "x" +
+                                    std::to_string(run.searchThreads) + "(" + run.splitSource + ")";
+            if (sharesAgentAcrossEpisodes(run)) {
+                run.persistentMcts = std::make_unique<MctsRolloutAgent>(*run.mctsParams);
             }
-        });
-    };
+        }
+    }
+}
 
-    int launched = 0;
-    while (launched < agentCfg.episodes) {
-        while (launched < agentCfg.episodes &&
-               workers.size() < threadsForEpisodes) {
-            launchEpisode(launched + 1);
-            ++launched;
+void finishAgentRun(AgentRun& run, tetris::RunWriter& writer);
+
+void runEpisode(AgentRun& run,
+                int episodeIndex,
+                tetris::RunWriter& writer,
+                std::mutex& logMutex,
+                std::atomic_bool& success) {
+    const std::optional<MctsParams>& paramsOpt = run.mctsParams;
+    const std::string modeName = "HeadlessBatch";
+    const bool deterministic = paramsOpt.has_value() && paramsOpt->deterministic;
+    std::optional<int> scoreLimit{};
+    std::optional<double> timeLimit{};
+    if (paramsOpt.has_value()) {
+        scoreLimit = paramsOpt->scoreLimit;
+        // O limite de tempo do episodio depende do relogio; no modo deterministico so vale o de score.
+        if (!deterministic) {
+            timeLimit = paramsOpt->timeLimitSeconds;
         }
+    }
+    const bool telemetry = paramsOpt.has_value() && paramsOpt->telemetry;
+
+    TetrisEnv env{};
+    std::optional<std::uint32_t> pieceSeed{};
+    if (run.pairedSeed.has_value()) {
+        pieceSeed = *run.pairedSeed + static_cast<std::uint32_t>(episodeIndex);
+    } else if (deterministic) {
+        pieceSeed = paramsOpt->seed.value_or(0) + static_cast<std::uint32_t>(episodeIndex);
+    } else if (run.traceFlags.has_value()) {
+        // O trace guarda a seed para o episodio poder ser reproduzido.
+        pieceSeed = std::random_device{}();
+    }
+    if (run.pairedSeed.has_value()) {
+        env.resetFixedStream(*pieceSeed);
+    } else if (pieceSeed.has_value()) {
+        env.reset(*pieceSeed);
+    } else {
+        env.reset();
+    }
 
-        for (auto& w : workers) {
-            if (w.joinable()) {
-                w.join();
+    const bool traceBoardHash = run.traceFlags.has_value() && (*run.traceFlags & tetris_env::trace::kFlagBoardHash) != 0;
+    std::vector<unsigned char> trace;
+    std::uint32_t traceSteps = 0;
+    if (run.traceFlags.has_value()) {
+        tetris_env::trace::encodeEpisodeStart(static_cast<std::uint32_t>(episodeIndex), pieceSeed.value_or(0), trace);
+    }
+
+    std::unique_ptr<Agent> agent;
+    MctsRolloutAgent* mctsAgent = nullptr;
+    if (run.canonicalType == "random") {
+        agent = std::make_unique<RandomAgent>();
+    } else if (run.canonicalType == "greedy") {
+        agent = std::make_unique<GreedyAgent>();
+    } else if (run.isMcts) {
+        if (!paramsOpt.has_value()) {
+            std::lock_guard<std::mutex> lock(logMutex);
+            std::cerr << "Erro interno: MCTS params nao carregados.\n";
+            success.store(false, std::memory_order_relaxed);
+            return;
+        }
+        if (run.persistentMcts) {
+            mctsAgent = run.persistentMcts.get();
+        } else {
+            auto mcts = std::make_unique<MctsRolloutAgent>(*paramsOpt);
+            mctsAgent = mcts.get();
+            agent = std::move(mcts);
+        }
+    } else {
+        std::lock_guard<std::mutex> lock(logMutex);
+        std::cerr << "Tipo de agente desconhecido: " << run.canonicalType << '\n';
+        success.store(false, std::memory_order_relaxed);
+        return;
+    }
+
+    Agent* const episodeAgent = agent ? agent.get() : mctsAgent;
+    std::vector<MctsMoveStats> moveTelemetry;
+    if (telemetry && mctsAgent != nullptr) {
+        mctsAgent->setTelemetryCallback([&moveTelemetry](const MctsMoveStats& stats) {
+            moveTelemetry.push_back(stats);
+        });
+    }
+    episodeAgent->onEpisodeStart();
+    if (mctsAgent != nullptr) {
+        mctsAgent->setEpisodeIndex(episodeIndex);
+    }
+    const auto start = std::chrono::steady_clock::now();
+    std::string endReason = "game_over";
+    std::vector<double> moveLatenciesMs;
+    long long searchIterations = 0;
+    double searchMs = 0.0;
+    std::size_t treePeakNodes = 0;
+    std::size_t treePeakBytes = 0;
+    long long treePrunedNodes = 0;
+    while (!env.isGameOver()) {
+        if (scoreLimit.has_value() && env.getScore() >= *scoreLimit) {
+            endReason = "score_limit";
+            break;
+        }
+
+        if (timeLimit.has_value()) {
+            const double elapsedSeconds =
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (elapsedSeconds >= *timeLimit) {
+                endReason = "time_limit";
+                break;
             }
         }
-        workers.clear();
 
-        if (!success.load(std::memory_order_relaxed)) {
+        const auto decisionStart = std::chrono::steady_clock::now();
+        const Action action = episodeAgent->chooseAction(env);
+        moveLatenciesMs.push_back(std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - decisionStart).count());
+        if (mctsAgent != nullptr) {
+            searchIterations += mctsAgent->lastMoveStats().iterations;
+            searchMs += mctsAgent->lastMoveStats().elapsedMs;
+            treePeakNodes = std::max(treePeakNodes, mctsAgent->lastMoveStats().peakNodes);
+            treePeakBytes = std::max(treePeakBytes, mctsAgent->lastMoveStats().peakNodeBytes);
+            treePrunedNodes += mctsAgent->lastMoveStats().prunedNodes;
+        }
+        const tetris_env::PieceType piece = env.getCurrentPieceType();
+        const StepResult result = env.step(action);
+        if (run.traceFlags.has_value()) {
+            tetris_env::trace::StepRecord step{};
+            step.piece = static_cast<std::uint8_t>(piece);
+            step.action = tetris_env::treedump::packAction(action);
+            step.linesCleared = static_cast<std::uint8_t>(result.linesCleared);
+            step.scoreDelta = static_cast<std::uint32_t>(std::max(0, result.scoreDelta));
+            step.latencyUs = static_cast<std::uint32_t>(moveLatenciesMs.back() * 1000.0);
+            if (traceBoardHash) {
+                step.boardHash = tetris_env::trace::hashBoard(tetris_env::bitboard::rowsFromBoard(env.getBoard()));
+            }
+            tetris_env::trace::encodeStep(step, traceBoardHash, trace);
+            ++traceSteps;
+        }
+        if (result.done) {
             break;
         }
     }
-
-    if (!success.load(std::memory_order_relaxed)) {
-        return false;
+    const auto end = std::chrono::steady_clock::now();
+    episodeAgent->onEpisodeEnd();
+    if (telemetry && mctsAgent != nullptr) {
+        mctsAgent->setTelemetryCallback({});
     }
 
-    std::sort(reports.begin(), reports.end(),
-              [](const tetris::EpisodeReport& a, const tetris::EpisodeReport& b) {
-                  return a.episodeIndex < b.episodeIndex;
-              });
+    tetris::EpisodeReport report{};
+    report.agentName = run.cfg.name;
+    report.modeName = modeName;
+    report.agentConfig = run.agentConfigString;
+    report.runId = run.runId;
+    report.episodeIndex = episodeIndex;
+    report.score = env.getScore();
+    report.totalLines = env.getTotalLinesCleared();
+    report.totalTurns = env.getTurnNumber();
+    report.holdsUsed = env.getHoldsUsed();
+    report.elapsedSeconds = std::chrono::duration<float>(end - start).count();
+    report.endReason = endReason;
+
+    const tetris::MoveLatencySummary latency = tetris::summarizeMoveLatencies(moveLatenciesMs);
+    report.moveLatencyP50Ms = static_cast<float>(latency.p50Ms);
+    report.moveLatencyP90Ms = static_cast<float>(latency.p90Ms);
+    report.moveLatencyP99Ms = static_cast<float>(latency.p99Ms);
+    report.moveLatencyMaxMs = static_cast<float>(latency.maxMs);
+    report.searchIterations = searchIterations;
+    report.searchSeconds = static_cast<float>(searchMs / 1000.0);
+    report.treePeakNodes = static_cast<long long>(treePeakNodes);
+    report.treePeakMb = static_cast<float>(static_cast<double>(treePeakBytes) / (1024.0 * 1024.0));
+    report.treePrunedNodes = treePrunedNodes;
+
+    std::lock_guard<std::mutex> lock(logMutex);
+    run.reports[static_cast<std::size_t>(episodeIndex - 1)] = report;
+    run.scoreStats.add(static_cast<double>(report.score));
+    run.moveLatenciesMs.insert(run.moveLatenciesMs.end(), moveLatenciesMs.begin(), moveLatenciesMs.end());
+    writer.appendMoveTelemetry(run.runId, episodeIndex, std::move(moveTelemetry), run.agentDir, run.filenameSuffix);
+    if (run.traceFlags.has_value()) {
+        tetris_env::trace::encodeEpisodeEnd(static_cast<std::uint32_t>(report.score), traceSteps, trace);
+        writer.appendEpisodeTrace(run.runId, std::move(trace), *run.traceFlags, run.agentDir, run.filenameSuffix);
+    }
+    writer.appendEpisodeReport(report, run.agentDir, run.filenameSuffix);
+    const int finished = ++run.completedEpisodes;
+    std::cout << "[Agente " << run.cfg.name << "] episodio " << episodeIndex
+              << " concluido: score=" << report.score
+              << " linhas=" << report.totalLines
+              << " turns=" << report.totalTurns
+              << " tempo=" << report.elapsedSeconds << "s"
+              << " latencia_p50=" << report.moveLatencyP50Ms << "ms"
+              << " p99=" << report.moveLatencyP99Ms << "ms";
+    if (run.isMcts) {
+        std::cout << " iteracoes=" << report.searchIterations;
+    }
+    if (endReason == "score_limit") {
+        std::cout << " (encerrado por limite de score)";
+    } else if (endReason == "time_limit") {
+        std::cout << " (encerrado por limite de tempo)";
+    }
+    if (run.isMcts) {
+        const double progress = static_cast<double>(finished) * 100.0 /
+                                 static_cast<double>(std::max(1, run.cfg.episodes));
+        std::cout << " progresso=" << finished << '/' << run.cfg.episodes
+                  << " (" << progress << "%)";
+    }
+    std::cout << '\n';
+}
 
-    for (const auto& rep : reports) {
-        tetris::appendEpisodeReportToRunFile(rep, agentDir, agentFilenameSuffix);
+void finishAgentRun(AgentRun& run, tetris::RunWriter& writer) {
+    std::vector<tetris::EpisodeReport> reports;
+    for (const auto& rep : run.reports) {
+        if (rep.has_value()) {
+            reports.push_back(*rep);
+        }
     }
+    writer.closeRun(run.runId, run.agentDir, run.filenameSuffix, reports);
 
     double sumScore = 0.0;
     double sumLines = 0.0;
+    double sumSearchIterations = 0.0;
+    double sumSearchSeconds = 0.0;
+    float treePeakMb = 0.0f;
+    long long treePrunedNodes = 0;
     for (const auto& rep : reports) {
+        treePeakMb = std::max(treePeakMb, rep.treePeakMb);
+        treePrunedNodes += rep.treePrunedNodes;
         sumScore += static_cast<double>(rep.score);
         sumLines += static_cast<double>(rep.totalLines);
+        sumSearchIterations += static_cast<double>(rep.searchIterations);
+        sumSearchSeconds += static_cast<double>(rep.searchSeconds);
     }
 
     const double avgScore = reports.empty() ? 0.0 : sumScore / static_cast<double>(reports.size());
     const double avgLines = reports.empty() ? 0.0 : sumLines / static_cast<double>(reports.size());
+    const tetris::MoveLatencySummary latency = tetris::summarizeMoveLatencies(std::move(run.moveLatenciesMs));
 
-    std::cout << "[Agente " << agentCfg.name << "] run_id=" << runId
+    std::cout << "[Agente " << run.cfg.name << "] run_id=" << run.runId
               << " episodios=" << reports.size()
-              << " threads=" << threadsForEpisodes;
-    if (isMctsAgent) {
-        std::cout << " mcts_threads=" << mctsThreadBudget;
+              << " threads=" << run.maxConcurrent;
+    if (run.resumedEpisodes > 0) {
+        std::cout << " retomados=" << run.resumedEpisodes;
+    }
+    if (!run.stopReason.empty()) {
+        std::cout << " parada_antecipada=" << run.stopReason;
+    }
+    if (run.isMcts) {
+        const double iterationsPerSecond = sumSearchSeconds > 0.0 ? sumSearchIterations / sumSearchSeconds : 0.0;
+        std::cout << " mcts_threads=" << run.searchThreads << " divisao=" << run.splitSource
+                  << " iter_por_s=" << iterationsPerSecond
+                  << " arvore_pico_mb=" << treePeakMb
+                  << " nos_podados=" << treePrunedNodes;
     }
     std::cout << " avg_score=" << avgScore
-              << " avg_lines=" << avgLines
-              << " -> agents/" << agentDir << "/run_" << runId << agentFilenameSuffix << ".csv\n";
+              << " avg_lines=" << avgLines;
+    // Sem latencias quando nenhuma jogada rodou neste processo (--merge ou tudo retomado).
+    if (latency.moves > 0) {
+        std::cout << " latencia_ms(p50/p90/p99/max)=" << latency.p50Ms << '/' << latency.p90Ms << '/'
+                  << latency.p99Ms << '/' << latency.maxMs;
+    }
+    std::cout << " -> agents/" << run.agentDir << "/run_" << run.runId << run.filenameSuffix << ".csv\n";
+}
+
+// Diferencas de score (run - baseline) nos episodios que os dois jogaram. Com o mutex de log.
+ScoreStats pairedDiffStats(const AgentRun& run, const AgentRun& baseline) {
+    ScoreStats diffs;
+    const std::size_t episodes = std::min(run.reports.size(), baseline.reports.size());
+    for (std::size_t i = 0; i < episodes; ++i) {
+        if (run.reports[i].has_value() && baseline.reports[i].has_value()) {
+            diffs.add(static_cast<double>(run.reports[i]->score) - static_cast<double>(baseline.reports[i]->score));
+        }
+    }
+    return diffs;
+}
+
+// Regras de parada antecipada, avaliadas a cada episodio concluido (com o mutex de log). Retorna o
+// motivo da parada ou vazio para continuar.
+//  - IC: meia-largura do IC95 da media do score <= stop_ci_half_width.
+//  - baseline: |media - media_baseline| >= 3 erros padrao da diferenca (Welch; no modo pareado,
+//    erro padrao da media das diferencas por episodio). O limiar de 3 em vez de 1.96 compensa
+//    olhar o teste de novo a cada episodio.
+std::string stopReasonFor(const AgentRun& run) {
+    constexpr double kCiZ = 1.96;
+    constexpr double kSequentialZ = 3.0;
+    const ScoreStats& stats = run.scoreStats;
+    if (stats.count < run.cfg.minEpisodes) {
+        return {};
+    }
+
+    if (run.cfg.stopCiHalfWidth.has_value()) {
+        const double halfWidth = kCiZ * std::sqrt(stats.meanVariance());
+        if (halfWidth <= *run.cfg.stopCiHalfWidth) {
+            std::ostringstream oss;
+            oss << "ic95(+-" << halfWidth << ')';
+            return oss.str();
+        }
+    }
+
+    if (run.baseline != nullptr && run.pairedSeed.has_value()) {
+        const ScoreStats diffs = pairedDiffStats(run, *run.baseline);
+        const double diff = diffs.mean;
+        const double se = std::sqrt(diffs.meanVariance());
+        if (diffs.count >= run.cfg.minEpisodes && se > 0.0 && std::abs(diff) >= kSequentialZ * se) {
+            std::ostringstream oss;
+            oss << (diff < 0.0 ? "pior_que_" : "melhor_que_") << run.baseline->cfg.name << "(pareado,dif=" << diff
+                << ",z=" << diff / se << ')';
+            return oss.str();
+        }
+    } else if (run.baseline != nullptr && run.baseline->scoreStats.count >= run.cfg.minEpisodes) {
+        const ScoreStats& base = run.baseline->scoreStats;
+        const double diff = stats.mean - base.mean;
+        const double se = std::sqrt(stats.meanVariance() + base.meanVariance());
+        if (se > 0.0 && std::abs(diff) >= kSequentialZ * se) {
+            std::ostringstream oss;
+            oss << (diff < 0.0 ? "pior_que_" : "melhor_que_") << run.baseline->cfg.name << "(dif=" << diff
+                << ",z=" << diff / se << ')';
+            return oss.str();
+        }
+    }
+    return {};
+}
 
+// Liga cada agente ao AgentRun do seu baseline; vale para o batch, o --merge e o --workers.
+void resolveBaselines(std::vector<AgentRun>& runs) {
+    for (AgentRun& run : runs) {
+        if (run.cfg.baseline.has_value()) {
+            for (AgentRun& other : runs) {
+                if (other.cfg.name == *run.cfg.baseline && &other != &run) {
+                    run.baseline = &other;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+// Escalonador global: um pool fixo de threads puxa episodios de todos os agentes do batch. Cada
+// episodio ocupa searchThreads fichas do orcamento; uma thread livre pega o primeiro agente (na
+// ordem do batch) com episodio pendente que cabe nas fichas livres. No modo pareado pega o menor
+// indice de episodio pendente, para os pares ficarem completos enquanto o batch avanca.
+bool runBatch(std::vector<AgentRun>& runs, unsigned int budget, tetris::RunWriter& writer) {
+    std::mutex scheduleMutex;
+    std::condition_variable released;
+    unsigned int freeThreads = budget;
+    std::uint64_t waitTickets = 0;
+    std::mutex logMutex;
+    std::atomic_bool success{true};
+
+    // Com o mutex do escalonador: corta a fila de um agente que atingiu a regra de parada e, quando
+    // nao ha mais episodios dele em andamento, fecha o agente. As fichas liberadas vao para os
+    // agentes que continuam.
+    auto settleAgent = [&](AgentRun& run) {
+        if (run.nextPending < run.pendingEpisodes.size()) {
+            std::lock_guard<std::mutex> logLock(logMutex);
+            run.stopReason = stopReasonFor(run);
+            if (!run.stopReason.empty()) {
+                std::cout << "[Agente " << run.cfg.name << "] parada antecipada apos " << run.scoreStats.count
+                          << " episodio(s): " << run.stopReason << "; "
+                          << run.pendingEpisodes.size() - run.nextPending << " episodio(s) nao jogado(s)\n";
+                run.nextPending = run.pendingEpisodes.size();
+            }
+        }
+        if (!run.finished && run.running == 0 && run.nextPending >= run.pendingEpisodes.size() &&
+            success.load(std::memory_order_relaxed)) {
+            run.finished = true;
+            std::lock_guard<std::mutex> logLock(logMutex);
+            finishAgentRun(run, writer);
+        }
+    };
+
+    for (AgentRun& run : runs) {
+        settleAgent(run);
+    }
+
+    auto poolWorker = [&]() {
+        std::unique_lock<std::mutex> lock(scheduleMutex);
+        while (success.load(std::memory_order_relaxed)) {
+            // Um job de varias fichas que nao coube fica na espera e as fichas ficam reservadas para o
+            // que espera ha mais tempo: sem isso, agentes de 1 ficha listados antes pegariam cada
+            // ficha liberada e o MCTS so rodaria quando as filas deles acabassem.
+            AgentRun* picked = nullptr;
+            AgentRun* reserved = nullptr;
+            bool pending = false;
+            for (AgentRun& run : runs) {
+                if (run.nextPending >= run.pendingEpisodes.size()) {
+                    continue;
+                }
+                pending = true;
+                if (run.running >= run.maxConcurrent) {
+                    continue;
+                }
+                if (run.searchThreads > 1 && (run.waitingSince > 0 || run.searchThreads > freeThreads)) {
+                    if (run.waitingSince == 0) {
+                        run.waitingSince = ++waitTickets;
+                    }
+                    if (reserved == nullptr || run.waitingSince < reserved->waitingSince) {
+                        reserved = &run;
+                    }
+                    continue;
+                }
+                if (run.searchThreads <= freeThreads &&
+                    (picked == nullptr ||
+                     (run.pairedSeed.has_value() &&
+                      run.pendingEpisodes[run.nextPending] < picked->pendingEpisodes[picked->nextPending]))) {
+                    picked = &run;
+                }
+            }
+            if (!pending) {
+                return;
+            }
+            if (reserved != nullptr) {
+                picked = reserved->searchThreads <= freeThreads ? reserved : nullptr;
+            }
+            if (picked == nullptr) {
+                released.wait(lock);
+                continue;
+            }
+
+            const int episodeIndex = picked->pendingEpisodes[picked->nextPending++];
+            picked->waitingSince = 0;
+            ++picked->running;
+            freeThreads -= picked->searchThreads;
+            lock.unlock();
+            runEpisode(*picked, episodeIndex, writer, logMutex, success);
+            lock.lock();
+            --picked->running;
+            freeThreads += picked->searchThreads;
+            settleAgent(*picked);
+            released.notify_all();
+        }
+    };
+
+    unsigned int poolSize = 0;
+    for (const AgentRun& run : runs) {
+        poolSize += run.maxConcurrent;
+    }
+    poolSize = std::clamp(poolSize, 1u, budget);
+    if (poolSize == 1) {
+        poolWorker();
+    } else {
+        std::vector<std::thread> workers;
+        workers.reserve(poolSize);
+        for (unsigned int i = 0; i < poolSize; ++i) {
+            workers.emplace_back(poolWorker);
+        }
+        for (auto& w : workers) {
+            w.join();
+        }
+    }
+    return success.load(std::memory_order_relaxed);
+}
+
+// Resumo do modo pareado: cada agente contra o seu baseline (ou o primeiro agente do batch), nos
+// episodios que os dois jogaram. Grava as diferencas por episodio em
+// agents/<agent_dir>/run_<runId>_<agente>_vs_<baseline>_pareado.csv.
+void reportPairedComparisons(const std::vector<AgentRun>& runs) {
+    for (const AgentRun& run : runs) {
+        const AgentRun* baseline = run.baseline != nullptr ? run.baseline : &runs.front();
+        if (baseline == &run) {
+            continue;
+        }
+
+        const std::filesystem::path csvPath = tetris::runFilePath(
+            run.runId, run.agentDir, run.filenameSuffix + "_vs_" + makeSafeSuffix(baseline->cfg.name) + "_pareado", ".csv");
+        std::ofstream csv(csvPath, std::ios::trunc);
+        if (!csv.is_open()) {
+            std::cerr << "Erro ao gravar diferencas pareadas em " << csvPath << '\n';
+        } else {
+            csv << "episode,piece_seed,score,baseline_score,diff,lines,baseline_lines\n";
+        }
+
+        ScoreStats diffs;
+        ScoreStats scores;
+        ScoreStats baseScores;
+        const std::size_t episodes = std::min(run.reports.size(), baseline->reports.size());
+        for (std::size_t i = 0; i < episodes; ++i) {
+            const auto& rep = run.reports[i];
+            const auto& base = baseline->reports[i];
+            if (!rep.has_value() || !base.has_value()) {
+                continue;
+            }
+            const long long diff = static_cast<long long>(rep->score) - static_cast<long long>(base->score);
+            diffs.add(static_cast<double>(diff));
+            scores.add(static_cast<double>(rep->score));
+            baseScores.add(static_cast<double>(base->score));
+            if (csv.is_open()) {
+                csv << rep->episodeIndex << ',' << *run.pairedSeed + static_cast<std::uint32_t>(rep->episodeIndex) << ','
+                    << rep->score << ',' << base->score << ',' << diff << ',' << rep->totalLines << ','
+                    << base->totalLines << '\n';
+            }
+        }
+
+        std::cout << "[Pareado] " << run.cfg.name << " - " << baseline->cfg.name << ": pares=" << diffs.count;
+        if (diffs.count < 2) {
+            std::cout << " (pares insuficientes)\n";
+            continue;
+        }
+        // Teste t pareado com aproximacao normal para o p-valor. A reducao de variancia compara o
+        // erro padrao pareado com o de duas amostras independentes do mesmo tamanho: e o fator de
+        // episodios que o pareamento economiza para o mesmo IC.
+        const double se = std::sqrt(diffs.meanVariance());
+        const double unpairedVariance = scores.meanVariance() + baseScores.meanVariance();
+        const double halfWidth = 1.96 * se;
+        std::cout << " dif_media=" << diffs.mean << " ic95=[" << diffs.mean - halfWidth << ", "
+                  << diffs.mean + halfWidth << ']';
+        if (se > 0.0) {
+            const double t = diffs.mean / se;
+            std::cout << " t=" << t << " p~" << std::erfc(std::abs(t) / std::sqrt(2.0));
+            std::cout << " reducao_variancia=" << unpairedVariance / (se * se) << 'x';
+        } else {
+            std::cout << " (diferencas constantes)";
+        }
+        std::cout << " -> " << csvPath.string() << '\n';
+    }
+}
+
+// Tabela da varredura: score medio contra custo por jogada de cada agente do batch, marcando os
+// pontos de Pareto (nenhum outro agente tem score maior ou igual com custo menor ou igual). O custo
+// e o tempo de parede por jogada (sobe com a concorrencia do batch); iter/jogada nao depende dela.
+// Tambem grava a tabela em agents/mcts_rollout/run_<runId>_sweep.csv.
+void reportSweep(const std::vector<AgentRun>& runs) {
+    struct Point {
+        const AgentRun* run = nullptr;
+        ScoreStats score;
+        double msPerMove = 0.0;
+        double iterationsPerMove = 0.0;
+        bool pareto = false;
+    };
+    std::vector<Point> points;
+    for (const AgentRun& run : runs) {
+        Point point{};
+        point.run = &run;
+        double seconds = 0.0;
+        double turns = 0.0;
+        double iterations = 0.0;
+        for (const auto& rep : run.reports) {
+            if (!rep.has_value()) {
+                continue;
+            }
+            point.score.add(static_cast<double>(rep->score));
+            seconds += static_cast<double>(rep->elapsedSeconds);
+            turns += static_cast<double>(rep->totalTurns);
+            iterations += static_cast<double>(rep->searchIterations);
+        }
+        if (point.score.count == 0) {
+            continue;
+        }
+        point.msPerMove = turns > 0.0 ? seconds * 1000.0 / turns : 0.0;
+        point.iterationsPerMove = turns > 0.0 ? iterations / turns : 0.0;
+        points.push_back(point);
+    }
+    for (Point& point : points) {
+        point.pareto = std::none_of(points.begin(), points.end(), [&](const Point& other) {
+            return &other != &point && other.score.mean >= point.score.mean && other.msPerMove <= point.msPerMove &&
+                   (other.score.mean > point.score.mean || other.msPerMove < point.msPerMove);
+        });
+    }
+    std::sort(points.begin(), points.end(), [](const Point& a, const Point& b) { return a.msPerMove < b.msPerMove; });
+    if (points.empty()) {
+        return;
+    }
+
+    const std::filesystem::path csvPath = tetris::runFilePath(points.front().run->runId, "mcts_rollout", "_sweep", ".csv");
+    std::filesystem::create_directories(csvPath.parent_path());
+    std::ofstream csv(csvPath, std::ios::trunc);
+    if (csv.is_open()) {
+        csv << "agent,episodes,avg_score,ci95_half_width,ms_per_move,iterations_per_move,pareto\n";
+    } else {
+        std::cerr << "Erro ao gravar a tabela da varredura em " << csvPath << '\n';
+    }
+
+    std::size_t nameWidth = 6;
+    for (const Point& point : points) {
+        nameWidth = std::max(nameWidth, point.run->cfg.name.size());
+    }
+    std::cout << "Varredura (ordenada por custo; * = Pareto score x ms/jogada):\n"
+              << "  " << std::left << std::setw(static_cast<int>(nameWidth)) << "agente" << std::right
+              << std::setw(6) << "eps" << std::setw(14) << "score_medio" << std::setw(12) << "ic95"
+              << std::setw(12) << "ms/jogada" << std::setw(14) << "iter/jogada" << '\n';
+    for (const Point& point : points) {
+        const double halfWidth = 1.96 * std::sqrt(point.score.meanVariance());
+        std::cout << (point.pareto ? "* " : "  ") << std::left << std::setw(static_cast<int>(nameWidth))
+                  << point.run->cfg.name << std::right << std::setw(6) << point.score.count << std::setw(14)
+                  << point.score.mean << std::setw(12) << halfWidth << std::setw(12) << point.msPerMove
+                  << std::setw(14) << point.iterationsPerMove << '\n';
+        if (csv.is_open()) {
+            csv << point.run->cfg.name << ',' << point.score.count << ',' << point.score.mean << ',' << halfWidth
+                << ',' << point.msPerMove << ',' << point.iterationsPerMove << ',' << (point.pareto ? 1 : 0) << '\n';
+        }
+    }
+    std::cout << "  -> " << csvPath.string() << '\n';
+}
+
+// --merge: junta os CSVs de shard (run_<runId><sufixo>_shard<i>of<n>.csv, gravados por processos
+// locais ou copiados de outras maquinas para agents/) no CSV normal de cada agente, na ordem dos
+// episodios. A telemetria dos shards e concatenada do mesmo jeito.
+bool mergeShards(std::vector<AgentRun>& runs, tetris::RunWriter& writer) {
+    namespace fs = std::filesystem;
+    bool complete = true;
+    for (AgentRun& run : runs) {
+        const std::string prefix = "run_" + run.runId + run.filenameSuffix + "_shard";
+        std::vector<fs::path> shardCsvs;
+        std::vector<fs::path> shardTelemetry;
+        std::vector<fs::path> shardTraces;
+        std::error_code ec;
+        for (const auto& entry : fs::directory_iterator(fs::path("agents") / run.agentDir, ec)) {
+            const std::string name = entry.path().filename().string();
+            if (name.rfind(prefix, 0) != 0 || name.find("_vs_") != std::string::npos) {
+                continue;
+            }
+            if (name.ends_with("_telemetry.jsonl")) {
+                shardTelemetry.push_back(entry.path());
+            } else if (name.ends_with(".ttrace")) {
+                shardTraces.push_back(entry.path());
+            } else if (name.ends_with(".csv")) {
+                shardCsvs.push_back(entry.path());
+            }
+        }
+        std::sort(shardCsvs.begin(), shardCsvs.end());
+        std::sort(shardTelemetry.begin(), shardTelemetry.end());
+        std::sort(shardTraces.begin(), shardTraces.end());
+        if (shardCsvs.empty()) {
+            std::cerr << "Aviso: nenhum CSV de shard do agente '" << run.cfg.name << "' (agents/" << run.agentDir
+                      << '/' << prefix << "*.csv)\n";
+            complete = false;
+            continue;
+        }
+
+        int dropped = 0;
+        for (const fs::path& path : shardCsvs) {
+            std::ifstream in(path);
+            std::string line;
+            std::getline(in, line); // cabecalho
+            while (std::getline(in, line)) {
+                tetris::EpisodeReport rep{};
+                if (!tetris::parseEpisodeCsvRow(line, rep) || rep.episodeIndex < 1 ||
+                    rep.episodeIndex > run.cfg.episodes || run.reports[static_cast<std::size_t>(rep.episodeIndex - 1)]) {
+                    ++dropped;
+                    continue;
+                }
+                run.reports[static_cast<std::size_t>(rep.episodeIndex - 1)] = rep;
+            }
+        }
+
+        const fs::path csvPath = tetris::runFilePath(run.runId, run.agentDir, run.filenameSuffix, ".csv");
+        const fs::path telemetryPath = tetris::runFilePath(run.runId, run.agentDir, run.filenameSuffix, "_telemetry.jsonl");
+        const fs::path tracePath = tetris::runFilePath(run.runId, run.agentDir, run.filenameSuffix, ".ttrace");
+        fs::remove(csvPath, ec);
+        fs::remove(telemetryPath, ec);
+        fs::remove(tracePath, ec);
+        for (const auto& rep : run.reports) {
+            if (rep.has_value()) {
+                run.scoreStats.add(static_cast<double>(rep->score));
+                writer.appendEpisodeReport(*rep, run.agentDir, run.filenameSuffix);
+            }
+        }
+        if (!shardTelemetry.empty()) {
+            std::ofstream out(telemetryPath, std::ios::binary | std::ios::trunc);
+            for (const fs::path& path : shardTelemetry) {
+                std::ifstream in(path, std::ios::binary);
+                out << in.rdbuf();
+            }
+        }
+        if (!shardTraces.empty()) {
+            // Cabecalho so do primeiro shard; os episodios dos outros vem em seguida.
+            std::ofstream out(tracePath, std::ios::binary | std::ios::trunc);
+            for (std::size_t i = 0; i < shardTraces.size(); ++i) {
+                std::ifstream in(shardTraces[i], std::ios::binary);
+                if (i > 0) {
+                    in.seekg(static_cast<std::streamoff>(tetris_env::trace::kHeaderSize));
+                }
+                out << in.rdbuf();
+            }
+        }
+
+        const int missing = run.cfg.episodes - run.scoreStats.count;
+        std::cout << "[Merge] agente '" << run.cfg.name << "': " << run.scoreStats.count << '/' << run.cfg.episodes
+                  << " episodio(s) de " << shardCsvs.size() << " arquivo(s) de shard";
+        if (dropped > 0) {
+            std::cout << ", " << dropped << " linha(s) invalida(s) ou repetida(s) descartada(s)";
+        }
+        if (missing > 0) {
+            std::cout << "; faltam " << missing << " episodio(s)";
+        }
+        std::cout << '\n';
+        finishAgentRun(run, writer);
+    }
+    return complete;
+}
+
+#ifndef _WIN32
+struct WorkerProcess {
+    int shard = 0;
+    pid_t pid = -1;
+    int fd = -1;
+    std::string pending; // saida parcial (sem fim de linha ainda)
+    int restarts = 0;
+};
+
+bool spawnWorker(const std::vector<std::string>& args, WorkerProcess& worker) {
+    int fds[2];
+    if (::pipe(fds) != 0) {
+        return false;
+    }
+    std::cout.flush();
+    std::fflush(nullptr);
+    const pid_t pid = ::fork();
+    if (pid < 0) {
+        ::close(fds[0]);
+        ::close(fds[1]);
+        return false;
+    }
+    if (pid == 0) {
+        ::dup2(fds[1], STDOUT_FILENO);
+        ::dup2(fds[1], STDERR_FILENO);
+        ::close(fds[0]);
+        ::close(fds[1]);
+        std::vector<char*> argv;
+        for (const std::string& arg : args) {
+            argv.push_back(const_cast<char*>(arg.c_str()));
+        }
+        argv.push_back(nullptr);
+        ::execv(argv[0], argv.data());
+        ::_exit(127);
+    }
+    ::close(fds[1]);
+    worker.pid = pid;
+    worker.fd = fds[0];
     return true;
 }
 
+// --workers n: roda cada shard num processo filho deste executavel e repassa a saida dele (stdout e
+// stderr pelo mesmo pipe) com o prefixo do shard. Um shard que cai (codigo de erro ou sinal) e
+// relancado uma vez com --resume e continua dos episodios ja gravados no seu CSV; os outros shards
+// seguem rodando. Retorna false se algum shard nao terminou.
+bool runWorkerProcesses(const std::string& exe,
+                        const std::string& configPath,
+                        const std::string& runId,
+                        int workers,
+                        unsigned int threadsPerWorker,
+                        bool resume) {
+    constexpr int kMaxRestarts = 1;
+    auto argsFor = [&](int shard, bool resumeShard) {
+        return std::vector<std::string>{exe, configPath, "--shard",
+                                        std::to_string(shard + 1) + "/" + std::to_string(workers), "--threads",
+                                        std::to_string(threadsPerWorker), resumeShard ? "--resume" : "--run-id", runId};
+    };
+    auto tag = [&](const WorkerProcess& worker) {
+        return "[shard " + std::to_string(worker.shard + 1) + "/" + std::to_string(workers) + "] ";
+    };
+
+    std::vector<WorkerProcess> processes(static_cast<std::size_t>(workers));
+    for (int i = 0; i < workers; ++i) {
+        processes[static_cast<std::size_t>(i)].shard = i;
+        if (!spawnWorker(argsFor(i, resume), processes[static_cast<std::size_t>(i)])) {
+            std::cerr << "Erro ao criar o processo do shard " << i + 1 << '\n';
+            return false;
+        }
+    }
+    std::cout << "Batch " << runId << " em " << workers << " processo(s), " << threadsPerWorker
+              << " thread(s) cada.\n";
+
+    bool success = true;
+    std::vector<pollfd> fds;
+    std::vector<WorkerProcess*> polled;
+    char buffer[4096];
+    while (true) {
+        fds.clear();
+        polled.clear();
+        for (WorkerProcess& worker : processes) {
+            if (worker.fd >= 0) {
+                fds.push_back(pollfd{worker.fd, POLLIN, 0});
+                polled.push_back(&worker);
+            }
+        }
+        if (fds.empty()) {
+            break;
+        }
+        if (::poll(fds.data(), fds.size(), -1) < 0) {
+            continue; // EINTR
+        }
+        for (std::size_t i = 0; i < fds.size(); ++i) {
+            if (fds[i].revents == 0) {
+                continue;
+            }
+            WorkerProcess& worker = *polled[i];
+            const ssize_t got = ::read(worker.fd, buffer, sizeof(buffer));
+            if (got > 0) {
+                worker.pending.append(buffer, static_cast<std::size_t>(got));
+                std::size_t lineEnd = 0;
+                while ((lineEnd = worker.pending.find('\n')) != std::string::npos) {
+                    std::cout << tag(worker) << worker.pending.substr(0, lineEnd + 1);
+                    worker.pending.erase(0, lineEnd + 1);
+                }
+                std::cout.flush();
+                continue;
+            }
+
+            // Fim do pipe: o processo terminou.
+            ::close(worker.fd);
+            worker.fd = -1;
+            if (!worker.pending.empty()) {
+                std::cout << tag(worker) << worker.pending << '\n';
+                worker.pending.clear();
+            }
+            int status = 0;
+            ::waitpid(worker.pid, &status, 0);
+            if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+                std::cout << tag(worker) << "concluido\n";
+                continue;
+            }
+            std::cerr << tag(worker) << "falhou ("
+                      << (WIFSIGNALED(status) ? "sinal " + std::to_string(WTERMSIG(status))
+                                              : "codigo " + std::to_string(WEXITSTATUS(status)))
+                      << ')';
+            if (worker.restarts < kMaxRestarts && spawnWorker(argsFor(worker.shard, true), worker)) {
+                ++worker.restarts;
+                std::cerr << "; relancado com --resume\n";
+            } else {
+                std::cerr << "; rode de novo com --shard " << worker.shard + 1 << '/' << workers << " --resume "
+                          << runId << " e depois --merge " << runId << '\n';
+                success = false;
+            }
+        }
+    }
+    return success;
+}
+#endif
+
 } // namespace
 
 int main(int argc, char** argv) {
     std::string configPath = "config/batch_runs.yaml";
-    if (argc > 1) {
-        std::string arg = argv[1];
+    std::optional<std::string> resumeRunId;
+    std::optional<std::string> fixedRunId;
+    std::optional<std::string> mergeRunId;
+    int shardIndex = 0;
+    int shardCount = 1;
+    int workers = 0;
+    int threadsOverride = 0;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
         if (arg == "--help" || arg == "-h") {
             printUsage();
             return 0;
         }
+        if (arg == "--resume" || arg == "--run-id" || arg == "--merge" || arg == "--shard" || arg == "--workers" ||
+            arg == "--threads") {
+            if (i + 1 >= argc) {
+                std::cerr << "Erro: " << arg << " precisa de um valor.\n";
+                return 1;
+            }
+            const std::string value = argv[++i];
+            if (arg == "--resume") {
+                resumeRunId = value;
+            } else if (arg == "--run-id") {
+                fixedRunId = value;
+            } else if (arg == "--merge") {
+                mergeRunId = value;
+            } else if (arg == "--shard") {
+                const auto slash = value.find('/');
+                int index = 0;
+                if (slash == std::string::npos || !tryParseInt(value.substr(0, slash), index) ||
+                    !tryParseInt(value.substr(slash + 1), shardCount) || shardCount < 1 || index < 1 ||
+                    index > shardCount) {
+                    std::cerr << "Erro: --shard espera i/n com 1 <= i <= n.\n";
+                    return 1;
+                }
+                shardIndex = index - 1;
+            } else if (!tryParseInt(value, arg == "--workers" ? workers : threadsOverride) ||
+                       (arg == "--workers" ? workers : threadsOverride) < 1) {
+                std::cerr << "Erro: " << arg << " espera um inteiro >= 1.\n";
+                return 1;
+            }
+            continue;
+        }
         configPath = arg;
     }
+    if ((workers > 0) + (shardCount > 1) + mergeRunId.has_value() > 1) {
+        std::cerr << "Erro: use so um de --workers, --shard e --merge.\n";
+        return 1;
+    }
+    if (shardCount > 1) {
+        // A saida do shard costuma ir para um pipe (--workers); linha a linha o coordenador a repassa na hora.
+        std::setvbuf(stdout, nullptr, _IOLBF, 0);
+    }
 
     const auto configOpt = loadBatchConfig(configPath);
     if (!configOpt.has_value()) {
@@ -579,7 +1729,9 @@ int main(int argc, char** argv) {
     const BatchConfig config = *configOpt;
 
     unsigned int maxThreads = 0;
-    if (config.threads > 0) {
+    if (threadsOverride > 0) {
+        maxThreads = static_cast<unsigned int>(threadsOverride);
+    } else if (config.threads > 0) {
         maxThreads = static_cast<unsigned int>(config.threads);
     } else {
         maxThreads = std::thread::hardware_concurrency();
@@ -588,28 +1740,114 @@ int main(int argc, char** argv) {
         maxThreads = 1;
     }
 
-    for (const auto& agentCfg : config.agents) {
-        const bool isMctsAgent = isMctsType(agentCfg.type);
-        unsigned int threadsForThisAgent = maxThreads;
-        if (!isMctsAgent && agentCfg.episodes < static_cast<int>(threadsForThisAgent)) {
-            threadsForThisAgent = static_cast<unsigned int>(std::max(1, agentCfg.episodes));
+    bool workersOk = true;
+    if (workers > 0) {
+#ifdef _WIN32
+        std::cerr << "Erro: --workers nao e suportado no Windows; rode cada --shard i/n e depois --merge.\n";
+        return 1;
+#else
+        std::error_code ec;
+        std::filesystem::path exe = std::filesystem::read_symlink("/proc/self/exe", ec);
+        if (ec) {
+            exe = argv[0];
         }
+        const std::string batchRunId = resumeRunId.value_or(fixedRunId.value_or(tetris::makeRunIdTimestamp()));
+        const int processCount = std::min(workers, std::max(1, static_cast<int>(maxThreads)));
+        workersOk = runWorkerProcesses(exe.string(), configPath, batchRunId, processCount,
+                                       std::max(1u, maxThreads / static_cast<unsigned int>(processCount)),
+                                       resumeRunId.has_value());
+        mergeRunId = batchRunId;
+        resumeRunId.reset();
+#endif
+    }
 
-        if (isMctsAgent) {
-            std::cout << "Executando agente '" << agentCfg.name << "' (" << agentCfg.type
-                      << ") com episodios sequenciais; ate " << threadsForThisAgent
-                      << " thread(s) por jogo MCTS...\n";
-        } else {
-            std::cout << "Executando agente '" << agentCfg.name << "' (" << agentCfg.type
-                      << ") com ate " << threadsForThisAgent
-                      << " jogo(s) em paralelo...\n";
+    // Um run_id para o batch inteiro; os agentes se distinguem pelo sufixo do arquivo.
+    const std::string runId =
+        mergeRunId.value_or(resumeRunId.value_or(fixedRunId.value_or(tetris::makeRunIdTimestamp())));
+    std::vector<AgentRun> runs(config.agents.size());
+    for (std::size_t i = 0; i < config.agents.size(); ++i) {
+        runs[i].pairedSeed = config.pairedSeed;
+        if (config.episodeTrace) {
+            runs[i].traceFlags = (config.episodeTraceBoardHash ? tetris_env::trace::kFlagBoardHash : 0u) |
+                                 (config.pairedSeed.has_value() ? tetris_env::trace::kFlagFixedPieceStream : 0u);
         }
-
-        const bool ok = runEpisodesForAgent(agentCfg, threadsForThisAgent, config.baseDir);
-        if (!ok) {
-            std::cerr << "Execucao interrompida para o agente '" << agentCfg.name << "'.\n";
+        runs[i].shardIndex = shardIndex;
+        runs[i].shardCount = shardCount;
+        if (!prepareAgentRun(config.agents[i], config.baseDir, runId, runs[i])) {
+            std::cerr << "Execucao interrompida para o agente '" << config.agents[i].name << "'.\n";
             return 1;
         }
+        for (std::size_t j = 0; j < i; ++j) {
+            if (runs[j].agentDir == runs[i].agentDir && runs[j].filenameSuffix == runs[i].filenameSuffix) {
+                runs[i].filenameSuffix = "_" + makeSafeSuffix(runs[i].cfg.name);
+                break;
+            }
+        }
+    }
+    resolveBaselines(runs);
+    if (mergeRunId.has_value()) {
+        tetris::RunWriter writer(config.columnarOutput);
+        const bool merged = mergeShards(runs, writer);
+        if (config.pairedSeed.has_value() && runs.size() > 1) {
+            reportPairedComparisons(runs);
+        }
+        if (config.hasSweep) {
+            reportSweep(runs);
+        }
+        return merged && workersOk ? 0 : 1;
+    }
+    if (shardCount > 1) {
+        const std::string shardSuffix = "_shard" + std::to_string(shardIndex + 1) + "of" + std::to_string(shardCount);
+        for (AgentRun& run : runs) {
+            run.filenameSuffix += shardSuffix;
+        }
+    }
+    if (resumeRunId.has_value()) {
+        int resumed = 0;
+        for (AgentRun& run : runs) {
+            if (!resumeAgentRun(run)) {
+                return 1;
+            }
+            resumed += run.resumedEpisodes;
+        }
+        std::cout << "Retomando batch " << runId << ": " << resumed << " episodio(s) ja concluido(s).\n";
+    }
+
+    planBatch(runs, maxThreads, config.calibrationSeconds);
+    if (config.pairedSeed.has_value()) {
+        for (AgentRun& run : runs) {
+            run.agentConfigString += (run.agentConfigString.empty() ? "" : " ") + std::string("paired_seed=") +
+                                     std::to_string(*config.pairedSeed);
+        }
+        std::cout << "Modo pareado: episodio i de todos os agentes com pecas da seed " << *config.pairedSeed
+                  << "+i.\n";
+    }
+    std::cout << "Batch " << runId << " com orcamento de " << maxThreads << " thread(s):\n";
+    for (const AgentRun& run : runs) {
+        std::cout << "  agente '" << run.cfg.name << "' (" << run.cfg.type << "): " << run.pendingEpisodes.size()
+                  << " episodio(s), ate " << run.maxConcurrent << " em paralelo";
+        if (run.isMcts) {
+            std::cout << ", " << run.searchThreads << " thread(s) de busca por jogo (" << run.splitSource << ")";
+        }
+        std::cout << '\n';
+    }
+
+    // Toda a gravacao de resultados passa por uma thread propria, que esvazia a fila ao sair.
+    tetris::RunWriter writer(config.columnarOutput);
+    if (!runBatch(runs, maxThreads, writer)) {
+        std::cerr << "Execucao do batch interrompida.\n";
+        return 1;
+    }
+    if (shardCount > 1) {
+        std::cout << "Shard " << shardIndex + 1 << '/' << shardCount << " concluido; junte os shards com --merge "
+                  << runId << ".\n";
+        return 0;
+    }
+    if (config.pairedSeed.has_value() && runs.size() > 1) {
+        reportPairedComparisons(runs);
+    }
+    if (config.hasSweep) {
+        reportSweep(runs);
     }
 
     return 0;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
 #include <deque>
 #include <queue>
 #include <random>
@@ -16,9 +17,17 @@ public:
     std::vector<int> peekN(const std::queue<int>& queue, std::size_t count) const;
     void registerUse(int pieceId);
     void resetHistory();
+    void seed(std::uint32_t value);
+    // Passa a sortear com um gerador leve (minstd) semeado por value, ate o proximo seed(). Para
+    // amostras descartaveis, onde semear o mt19937 custaria mais que a amostra.
+    void seedSampled(std::uint32_t value);
+    // Copia o historico de repeticao de other, sem os geradores.
+    void copyHistoryFrom(const Bag& other);
 
 private:
     mutable std::mt19937 rng_;
+    std::minstd_rand sampledRng_{};
+    bool sampled_ = false;
     std::array<int, 7> pieces_{};
     int lastQueued_ = -1;
     std::deque<int> recent_;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
 #include <queue>
 #include <vector>
 
@@ -24,6 +25,13 @@ public:
 
     void reset();
     void start();
+    void seed(std::uint32_t value); // fixa a sequencia de pecas gerada a partir do proximo reset
+    // Sequencia de pecas funcao so da seed: a troca com o hold nao entra no historico de repeticao
+    // do Bag (que passa a seguir so a ordem da fila). Vale ate ser desligado; reset nao muda.
+    void setFixedPieceStream(bool enabled);
+    // Copia o estado de other (tabuleiro, pecas, fila, hold, score) sem o gerador das pecas e passa
+    // a sortear as proximas com Bag::seedSampled(pieceSeed).
+    void copySampledFrom(const Game& other, std::uint32_t pieceSeed);
 
     static Cell spawnOrigin();
 
@@ -50,6 +58,7 @@ public:
     std::array<Cell, 4> activeCells() const;
     std::array<Cell, 4> ghostCells() const;
     std::vector<int> queuePreview(std::size_t count) const;
+    int nextPieceId() const; // -1 se a fila estiver vazia
 
     bool hasActivePiece() const;
     int activePieceId() const;
@@ -69,6 +78,7 @@ private:
     ActivePiece active_{};
     int hold_ = -1;
     bool holdUsed_ = false;
+    bool fixedPieceStream_ = false;
     Score score_{};
     GameState state_ = GameState::Menu;
     float dropTimer_ = 0.0f;
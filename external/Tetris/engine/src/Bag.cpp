@@ -22,7 +22,11 @@ void Bag::refill(std::queue<int>& queue, std::size_t targetSize) {
 
     while (queue.size() < targetSize) {
         std::array<int, 7> bag = pieces_;
-        std::shuffle(bag.begin(), bag.end(), rng_);
+        if (sampled_) {
+            std::shuffle(bag.begin(), bag.end(), sampledRng_);
+        } else {
+            std::shuffle(bag.begin(), bag.end(), rng_);
+        }
 
         for (std::size_t i = 0; i < bag.size() && queue.size() < targetSize; ++i) {
             auto shouldAvoid = [&](int candidate) {
@@ -79,4 +83,20 @@ void Bag::resetHistory() {
     recent_.clear();
 }
 
+void Bag::seed(std::uint32_t value) {
+    rng_.seed(value);
+    sampled_ = false;
+}
+
+void Bag::seedSampled(std::uint32_t value) {
+    sampledRng_.seed(value);
+    sampled_ = true;
+}
+
+void Bag::copyHistoryFrom(const Bag& other) {
+    lastQueued_ = other.lastQueued_;
+    recent_ = other.recent_;
+    recentLimit_ = other.recentLimit_;
+}
+
 } // namespace tetris
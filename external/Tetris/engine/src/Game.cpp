@@ -42,6 +42,29 @@ void Game::reset() {
     state_ = GameState::Menu;
 }
 
+void Game::seed(std::uint32_t value) {
+    bag_.seed(value);
+}
+
+void Game::setFixedPieceStream(bool enabled) {
+    fixedPieceStream_ = enabled;
+}
+
+void Game::copySampledFrom(const Game& other, std::uint32_t pieceSeed) {
+    board_ = other.board_;
+    bag_.copyHistoryFrom(other.bag_);
+    bag_.seedSampled(pieceSeed);
+    nextPieces_ = other.nextPieces_;
+    active_ = other.active_;
+    hold_ = other.hold_;
+    holdUsed_ = other.holdUsed_;
+    fixedPieceStream_ = other.fixedPieceStream_;
+    score_ = other.score_;
+    state_ = other.state_;
+    dropTimer_ = other.dropTimer_;
+    queueSize_ = other.queueSize_;
+}
+
 void Game::start() {
     reset();
     state_ = GameState::Playing;
@@ -115,7 +138,9 @@ void Game::hold() {
         active_.rotation = 0;
         active_.origin = spawnOrigin();
         dropTimer_ = 0.0f;
-        bag_.registerUse(active_.id);
+        if (!fixedPieceStream_) {
+            bag_.registerUse(active_.id);
+        }
         if (!canPlace(active_.id, active_.rotation, active_.origin)) {
             state_ = GameState::GameOver;
         }
@@ -194,6 +219,10 @@ std::vector<int> Game::queuePreview(std::size_t count) const {
     return bag_.peekN(nextPieces_, count);
 }
 
+int Game::nextPieceId() const {
+    return nextPieces_.empty() ? -1 : nextPieces_.front();
+}
+
 bool Game::hasActivePiece() const {
     return active_.id >= 0 && state_ == GameState::Playing;
 }
@@ -1,22 +1,28 @@
 #include "tetris/App.hpp"
 
 #include <array>
+#include <atomic>
 #include <chrono>
 #include <cctype>
+#include <condition_variable>
 #include <cstdint>
 #include <filesystem>
 #include <fstream>
-#include <future>
 #include <iomanip>
 #include <iostream>
 #include <limits>
+#include <mutex>
 #include <optional>
 #include <sstream>
 #include <ctime>
 #include <algorithm>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include "tetris_env/GreedyAgent.hpp"
 #include "tetris_env/MctsConfig.hpp"
+#include "tetris_env/MoveLatency.hpp"
 #include "tetris_env/RandomAgent.hpp"
 #include "tetris_env/RunLogging.hpp"
 #include "tetris_env/TetrisEnv.hpp"
@@ -58,6 +64,103 @@ bool isMctsMode(PlayMode mode) {
            mode == PlayMode::MctsTranspositionAI;
 }
 
+// Thread persistente da busca na GUI: decide a jogada pedida e, com ponder, segue buscando no
+// estado previsto ate chegar o proximo pedido. A latencia e medida aqui para nao depender da
+// cadencia de frames.
+class AgentSearchWorker {
+public:
+    AgentSearchWorker(::Agent& agent, ::MctsRolloutAgent* ponderAgent)
+        : agent_(agent), ponderAgent_(ponderAgent), thread_([this]() { run(); }) {}
+
+    ~AgentSearchWorker() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            quit_ = true;
+            stopPonder_ = true;
+        }
+        wake_.notify_one();
+        thread_.join();
+    }
+
+    AgentSearchWorker(const AgentSearchWorker&) = delete;
+    AgentSearchWorker& operator=(const AgentSearchWorker&) = delete;
+
+    void decide(const ::TetrisEnv& state) {
+        submit(Job{JobKind::Decide, state.clone()});
+    }
+
+    void ponder(const ::TetrisEnv& predicted) {
+        if (ponderAgent_ != nullptr) {
+            submit(Job{JobKind::Ponder, predicted.clone()});
+        }
+    }
+
+    std::optional<std::pair<::Action, double>> poll() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto ready = std::move(result_);
+        result_.reset();
+        return ready;
+    }
+
+private:
+    enum class JobKind {
+        Decide,
+        Ponder
+    };
+
+    struct Job {
+        JobKind kind = JobKind::Decide;
+        ::TetrisEnv state;
+    };
+
+    // Um pedido novo substitui o pendente e interrompe o ponder em andamento.
+    void submit(Job job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            job_ = std::move(job);
+            stopPonder_ = true;
+        }
+        wake_.notify_one();
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            wake_.wait(lock, [this]() { return quit_ || job_.has_value(); });
+            if (quit_) {
+                return;
+            }
+            Job job = std::move(*job_);
+            job_.reset();
+            stopPonder_ = false;
+            lock.unlock();
+
+            if (job.kind == JobKind::Ponder) {
+                ponderAgent_->ponder(job.state, stopPonder_);
+                lock.lock();
+                continue;
+            }
+
+            const auto start = std::chrono::steady_clock::now();
+            const ::Action action = agent_.chooseAction(job.state);
+            const double latencyMs =
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            lock.lock();
+            result_ = std::make_pair(action, latencyMs);
+        }
+    }
+
+    ::Agent& agent_;
+    ::MctsRolloutAgent* ponderAgent_ = nullptr;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::optional<Job> job_;
+    std::optional<std::pair<::Action, double>> result_;
+    std::atomic<bool> stopPonder_{false};
+    bool quit_ = false;
+    std::thread thread_;
+};
+
 } // namespace
 
 
@@ -251,6 +354,7 @@ bool App::runGameLoopAI(PlayMode mode, EpisodeReport& report) {
     std::string endReason = "game_over";
 
     std::unique_ptr<::Agent> agent{};
+    ::MctsRolloutAgent* ponderAgent = nullptr;
     switch (mode) {
         case PlayMode::RandomAI:
             agent = std::make_unique<::RandomAgent>();
@@ -291,7 +395,11 @@ bool App::runGameLoopAI(PlayMode mode, EpisodeReport& report) {
             scoreLimit = params.scoreLimit;
             timeLimitSeconds = params.timeLimitSeconds;
 
-            agent = std::make_unique<::MctsRolloutAgent>(params);
+            auto mctsAgent = std::make_unique<::MctsRolloutAgent>(params);
+            if (params.ponder) {
+                ponderAgent = mctsAgent.get();
+            }
+            agent = std::move(mctsAgent);
             break;
         }
         case PlayMode::Human:
@@ -306,34 +414,18 @@ bool App::runGameLoopAI(PlayMode mode, EpisodeReport& report) {
     const float actionInterval = 0.4f;
     const bool mctsSelected = isMctsMode(mode);
     float elapsedSeconds = 0.0f;
+    std::vector<double> moveLatenciesMs;
 
-    std::future<::Action> mctsFuture;
+    // A jogada decidida fica guardada ate o intervalo de exibicao passar; enquanto isso o worker
+    // pondera sobre o estado que ela vai produzir.
+    std::unique_ptr<AgentSearchWorker> searchWorker{};
     bool mctsActionPending = false;
-
-    auto launchMctsSearch = [&](const ::TetrisEnv& state) {
-        if (!mctsSelected || mctsActionPending || state.isGameOver()) {
-            return;
-        }
-        ::TetrisEnv snapshot = state.clone();
-        mctsFuture = std::async(std::launch::async, [agentPtr = agent.get(), snapshot]() mutable {
-            return agentPtr->chooseAction(snapshot);
-        });
-        mctsActionPending = true;
-    };
-
-    auto pollMctsAction = [&]() -> std::optional<::Action> {
-        if (!mctsActionPending) {
-            return std::nullopt;
-        }
-        if (mctsFuture.wait_for(std::chrono::milliseconds(0)) != std::future_status::ready) {
-            return std::nullopt;
-        }
-        mctsActionPending = false;
-        return mctsFuture.get();
-    };
+    std::optional<::Action> mctsReadyAction{};
 
     if (mctsSelected) {
-        launchMctsSearch(env);
+        searchWorker = std::make_unique<AgentSearchWorker>(*agent, ponderAgent);
+        searchWorker->decide(env);
+        mctsActionPending = true;
     }
 
     bool shouldStop = false;
@@ -369,8 +461,17 @@ bool App::runGameLoopAI(PlayMode mode, EpisodeReport& report) {
             break;
         }
 
-        if (mctsSelected && !mctsActionPending && !env.isGameOver()) {
-            launchMctsSearch(env);
+        if (mctsActionPending) {
+            if (auto ready = searchWorker->poll()) {
+                mctsActionPending = false;
+                moveLatenciesMs.push_back(ready->second);
+                mctsReadyAction = ready->first;
+                if (ponderAgent != nullptr) {
+                    ::TetrisEnv predicted = env.clone();
+                    predicted.step(ready->first);
+                    searchWorker->ponder(predicted);
+                }
+            }
         }
 
         if (accumulator >= actionInterval && !env.isGameOver()) {
@@ -382,14 +483,17 @@ bool App::runGameLoopAI(PlayMode mode, EpisodeReport& report) {
                 ::Action action{};
 
                 if (mctsSelected) {
-                    auto readyAction = pollMctsAction();
-                    if (!readyAction.has_value()) {
+                    if (!mctsReadyAction.has_value()) {
                         actionReady = false;
                     } else {
-                        action = *readyAction;
+                        action = *mctsReadyAction;
+                        mctsReadyAction.reset();
                     }
                 } else {
+                    const auto decisionStart = std::chrono::steady_clock::now();
                     action = agent->chooseAction(env);
+                    moveLatenciesMs.push_back(std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - decisionStart).count());
                 }
 
                 if (actionReady) {
@@ -399,7 +503,8 @@ bool App::runGameLoopAI(PlayMode mode, EpisodeReport& report) {
                         shouldStop = true;
                     }
                     if (mctsSelected && !shouldStop) {
-                        launchMctsSearch(env);
+                        searchWorker->decide(env);
+                        mctsActionPending = true;
                     }
                 }
             }
@@ -408,9 +513,8 @@ bool App::runGameLoopAI(PlayMode mode, EpisodeReport& report) {
         renderer_->draw(window_, env.game(), font_);
     }
 
-    if (mctsSelected && mctsActionPending) {
-        mctsFuture.wait();
-    }
+    // Interrompe o ponder e espera a decisao em andamento, se houver.
+    searchWorker.reset();
 
     report.score = env.getScore();
     report.totalLines = env.getTotalLinesCleared();
@@ -419,6 +523,12 @@ bool App::runGameLoopAI(PlayMode mode, EpisodeReport& report) {
     report.elapsedSeconds = elapsedSeconds;
     report.endReason = endReason;
 
+    const MoveLatencySummary latency = summarizeMoveLatencies(std::move(moveLatenciesMs));
+    report.moveLatencyP50Ms = static_cast<float>(latency.p50Ms);
+    report.moveLatencyP90Ms = static_cast<float>(latency.p90Ms);
+    report.moveLatencyP99Ms = static_cast<float>(latency.p99Ms);
+    report.moveLatencyMaxMs = static_cast<float>(latency.maxMs);
+
     return window_.isOpen();
 }
 
@@ -187,7 +187,20 @@ bool Hud::showGameOver(sf::RenderWindow& window, const config::Layout& layout, c
                 layout.desktop.width / 2.0f - timeBounds.width / 2.0f,
                 nextLineY);
             window.draw(timeText);
-            nextLineY += timeBounds.height + 20.0f;
+            nextLineY += timeBounds.height + 10.0f;
+
+            std::ostringstream latencySs;
+            latencySs << std::fixed << std::setprecision(1)
+                      << "Latencia p50/p90/p99: " << report.moveLatencyP50Ms << " / "
+                      << report.moveLatencyP90Ms << " / " << report.moveLatencyP99Ms << " ms";
+            sf::Text latencyText(latencySs.str(), font_, 32);
+            latencyText.setFillColor(sf::Color(200, 200, 200));
+            const auto latencyBounds = latencyText.getLocalBounds();
+            latencyText.setPosition(
+                layout.desktop.width / 2.0f - latencyBounds.width / 2.0f,
+                nextLineY);
+            window.draw(latencyText);
+            nextLineY += latencyBounds.height + 20.0f;
 
             if (!report.agentConfig.empty()) {
                 sf::Text configText("Config: " + report.agentConfig, font_, 32);
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "tetris_env/Bitboard.hpp"
+#include "tetris_env/TetrisEnv.hpp"
+
+namespace tetris_env {
+
+// Executa K rollouts simultaneos (lanes) a partir do mesmo estado. Cada campo do estado das
+// lanes fica num array proprio (tabuleiro em bitboard, peca ativa, hold, cursor na sequencia,
+// RNG, recompensa) e as lanes avancam em passo sincronizado. A fila visivel do ambiente e
+// comum a todas; alem dela cada lane sorteia as pecas em sacos de 7 com seu proprio RNG.
+class BatchRolloutSimulator {
+public:
+    explicit BatchRolloutSimulator(int lanes = 1);
+
+    int lanes() const { return lanes_; }
+
+    // Simulam ate `steps` jogadas por lane e retornam a recompensa media entre as lanes.
+    // heuristicValue: recompensa por passo de evaluateGreedyStep (senao o scoreDelta).
+    // leafWeight: soma leafWeight * evaluateBoardState ao estado final de cada lane viva.
+    double runRandom(const TetrisEnv& env, int steps, bool heuristicValue, double leafWeight, std::mt19937& rng);
+    double runGreedy(const TetrisEnv& env, int steps, bool heuristicValue, double leafWeight, std::mt19937& rng);
+
+private:
+    template <bool Greedy>
+    double run(const TetrisEnv& env, int steps, bool heuristicValue, double leafWeight, std::mt19937& rng);
+    void load(const TetrisEnv& env, int steps, std::mt19937& rng);
+    template <bool Greedy>
+    void stepLane(int lane, bool holdAllowed, bool heuristicValue);
+
+    int lanes_ = 1;
+    std::size_t sequenceStride_ = 0;
+    bool canHoldFirst_ = true;
+
+    std::vector<bitboard::Rows> rows_;
+    std::vector<std::int8_t> active_;
+    std::vector<std::int8_t> hold_;
+    std::vector<std::uint8_t> alive_;
+    std::vector<std::uint32_t> cursor_;
+    std::vector<std::uint64_t> rngState_;
+    std::vector<double> reward_;
+    std::vector<std::int8_t> sequence_; // lanes_ * sequenceStride_
+};
+
+} // namespace tetris_env
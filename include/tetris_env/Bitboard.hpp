@@ -0,0 +1,178 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+
+#include "tetris/Board.hpp"
+#include "tetris/EngineConfig.hpp"
+#include "tetris/Tetromino.hpp"
+#include "tetris/Types.hpp"
+#include "tetris_env/BoardHeuristic.hpp"
+
+// Primitivas de tabuleiro em bitboard (uma palavra de 16 bits por linha) usadas pelos
+// kernels de rollout. Reproduzem as regras de Game: rotacao na origem, deslocamento
+// horizontal, queda, travamento e limpeza de linhas.
+namespace tetris_env::bitboard {
+
+constexpr int kWidth = tetris::engine_cfg::fieldWidth;
+constexpr int kHeight = tetris::engine_cfg::fieldHeight;
+constexpr int kPieceCount = 7;
+constexpr std::uint16_t kFullRow = static_cast<std::uint16_t>((1u << kWidth) - 1u);
+
+using Rows = std::array<std::uint16_t, kHeight>;
+
+struct Shape {
+    std::array<tetris::Cell, 4> cells{};
+    int minX = 0;
+    int maxX = 0;
+};
+
+struct ShapeTable {
+    std::array<std::array<Shape, 4>, kPieceCount> shapes{};
+
+    ShapeTable() {
+        const auto& set = tetris::TetrominoSet::instance();
+        for (int id = 0; id < kPieceCount; ++id) {
+            for (int rotation = 0; rotation < 4; ++rotation) {
+                Shape& shape = shapes[static_cast<std::size_t>(id)][static_cast<std::size_t>(rotation)];
+                shape.cells = set.cells(id, rotation, tetris::Cell{0, 0});
+                shape.minX = shape.cells[0].x;
+                shape.maxX = shape.cells[0].x;
+                for (const auto& cell : shape.cells) {
+                    shape.minX = std::min(shape.minX, cell.x);
+                    shape.maxX = std::max(shape.maxX, cell.x);
+                }
+            }
+        }
+    }
+};
+
+inline const ShapeTable& shapeTable() {
+    static const ShapeTable table;
+    return table;
+}
+
+inline const Shape& shapeOf(int id, int rotation) {
+    return shapeTable().shapes[static_cast<std::size_t>(id % kPieceCount)][static_cast<std::size_t>(rotation & 3)];
+}
+
+inline Rows rowsFromBoard(const tetris::Board& board) {
+    Rows rows{};
+    const auto& grid = board.data();
+    for (int y = 0; y < kHeight; ++y) {
+        std::uint16_t bits = 0;
+        for (int x = 0; x < kWidth; ++x) {
+            if (grid[static_cast<std::size_t>(y)][static_cast<std::size_t>(x)] != 0) {
+                bits = static_cast<std::uint16_t>(bits | (1u << x));
+            }
+        }
+        rows[static_cast<std::size_t>(y)] = bits;
+    }
+    return rows;
+}
+
+inline bool fits(const Rows& rows, int id, int rotation, int ox, int oy) {
+    for (const auto& cell : shapeOf(id, rotation).cells) {
+        const int x = ox + cell.x;
+        const int y = oy + cell.y;
+        if (x < 0 || x >= kWidth || y < 0 || y >= kHeight) {
+            return false;
+        }
+        if ((rows[static_cast<std::size_t>(y)] >> x) & 1u) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Espelha Game::simulatePlacement: gira na origem, desloca na horizontal e cai.
+inline bool simulateLanding(const Rows& rows, const tetris::ActivePiece& start, int targetRotation, int targetX,
+                            tetris::ActivePiece& landing) {
+    tetris::ActivePiece piece = start;
+    while (piece.rotation != targetRotation) {
+        const int nextRotation = (piece.rotation + 1) % 4;
+        if (!fits(rows, piece.id, nextRotation, piece.origin.x, piece.origin.y)) {
+            return false;
+        }
+        piece.rotation = nextRotation;
+    }
+
+    const int step = targetX > piece.origin.x ? 1 : -1;
+    while (piece.origin.x != targetX) {
+        if (!fits(rows, piece.id, piece.rotation, piece.origin.x + step, piece.origin.y)) {
+            return false;
+        }
+        piece.origin.x += step;
+    }
+
+    while (fits(rows, piece.id, piece.rotation, piece.origin.x, piece.origin.y + 1)) {
+        ++piece.origin.y;
+    }
+
+    landing = piece;
+    return true;
+}
+
+inline int lockAndClear(Rows& rows, const tetris::ActivePiece& piece) {
+    for (const auto& cell : shapeOf(piece.id, piece.rotation).cells) {
+        rows[static_cast<std::size_t>(piece.origin.y + cell.y)] |=
+            static_cast<std::uint16_t>(1u << (piece.origin.x + cell.x));
+    }
+
+    int target = kHeight - 1;
+    int cleared = 0;
+    for (int row = kHeight - 1; row >= 0; --row) {
+        const std::uint16_t bits = rows[static_cast<std::size_t>(row)];
+        if (bits == kFullRow) {
+            ++cleared;
+            continue;
+        }
+        rows[static_cast<std::size_t>(target)] = bits;
+        --target;
+    }
+    for (int row = target; row >= 0; --row) {
+        rows[static_cast<std::size_t>(row)] = 0;
+    }
+    return cleared;
+}
+
+inline BoardFeatures featuresOf(const Rows& rows) {
+    std::array<int, kWidth> heights{};
+    BoardFeatures f{};
+    std::uint16_t covered = 0;
+    for (int y = 0; y < kHeight; ++y) {
+        const std::uint16_t bits = rows[static_cast<std::size_t>(y)];
+        // Celulas vazias sob uma coluna ja coberta sao buracos.
+        const std::uint16_t holes = static_cast<std::uint16_t>(covered & ~bits);
+        for (std::uint16_t m = holes; m != 0; m = static_cast<std::uint16_t>(m & (m - 1))) {
+            ++f.holes;
+        }
+        const std::uint16_t fresh = static_cast<std::uint16_t>(bits & ~covered);
+        for (int x = 0; x < kWidth; ++x) {
+            if ((fresh >> x) & 1u) {
+                heights[static_cast<std::size_t>(x)] = kHeight - y;
+            }
+        }
+        covered |= bits;
+    }
+
+    for (int x = 0; x < kWidth; ++x) {
+        const int h = heights[static_cast<std::size_t>(x)];
+        f.totalHeight += h;
+        f.maxHeight = std::max(f.maxHeight, h);
+        if (x + 1 < kWidth) {
+            f.bumpiness += std::abs(h - heights[static_cast<std::size_t>(x + 1)]);
+        }
+    }
+    return f;
+}
+
+inline int lineScore(int lines) {
+    tetris::Score score{};
+    score.addLines(lines);
+    return score.value;
+}
+
+} // namespace tetris_env::bitboard
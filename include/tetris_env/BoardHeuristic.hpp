@@ -18,4 +18,7 @@ double evaluateGreedyStep(const BoardFeatures& before,
                           const BoardFeatures& after,
                           const StepResult& stepResult);
 
+// Valor estatico de um tabuleiro (penalidades de buracos, altura e irregularidade do Greedy).
+double evaluateBoardState(const BoardFeatures& features);
+
 } // namespace tetris_env
@@ -19,6 +19,21 @@ struct EpisodeReport {
 
     float elapsedSeconds = 0.0f;
     std::string endReason = "game_over"; // game_over | score_limit | time_limit
+
+    // Latencia de decisao por jogada (ms), em percentis.
+    float moveLatencyP50Ms = 0.0f;
+    float moveLatencyP90Ms = 0.0f;
+    float moveLatencyP99Ms = 0.0f;
+    float moveLatencyMaxMs = 0.0f;
+
+    // Esforco de busca acumulado no episodio (somente agentes MCTS).
+    long long searchIterations = 0;
+    float searchSeconds = 0.0f;
+
+    // Pico de memoria das arvores de busca numa jogada (somado entre threads) e nos podados.
+    long long treePeakNodes = 0;
+    float treePeakMb = 0.0f;
+    long long treePrunedNodes = 0;
 };
 
 } // namespace tetris
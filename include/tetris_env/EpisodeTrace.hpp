@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <vector>
+
+#include "tetris_env/Bitboard.hpp"
+
+// Trace compacto por jogada dos episodios (varints LEB128; inteiros fixos little-endian).
+//
+// Arquivo: magic "TETRTRCE", u32 versao, u32 flags (bit 0: jogadas trazem o hash do tabuleiro;
+// bit 1: pecas em sequencia fixa, reproduzir com TetrisEnv::resetFixedStream(seed)).
+// Episodio: varint episodio, varint seed das pecas, as jogadas, byte kEndMarker, varint score
+// final e varint quantidade de jogadas (conferida na leitura).
+// Jogada: u8 peca (3 bits) | linhas limpas << 3, u8 acao (treedump::packAction), varint
+// incremento de score, varint latencia da decisao em us e, com a flag, u32 hash do tabuleiro
+// depois da jogada. Uma jogada comum ocupa 4 a 6 bytes.
+namespace tetris_env::trace {
+
+constexpr std::uint32_t kVersion = 1;
+constexpr std::uint32_t kFlagBoardHash = 1u;
+constexpr std::uint32_t kFlagFixedPieceStream = 2u;
+constexpr std::size_t kHeaderSize = 16;
+constexpr std::uint8_t kEndMarker = 0xFF; // nunca e um primeiro byte de jogada valido
+
+struct StepRecord {
+    std::uint8_t piece = 0;
+    std::uint8_t action = 0;
+    std::uint8_t linesCleared = 0;
+    std::uint32_t scoreDelta = 0;
+    std::uint32_t latencyUs = 0;
+    std::uint32_t boardHash = 0;
+};
+
+struct EpisodeRecord {
+    std::uint32_t episode = 0;
+    std::uint32_t seed = 0;
+    std::uint32_t finalScore = 0;
+    std::vector<StepRecord> steps;
+};
+
+// FNV-1a de 32 bits das linhas do tabuleiro.
+std::uint32_t hashBoard(const bitboard::Rows& rows);
+
+void encodeHeader(std::uint32_t flags, std::vector<unsigned char>& out);
+void encodeEpisodeStart(std::uint32_t episode, std::uint32_t seed, std::vector<unsigned char>& out);
+void encodeStep(const StepRecord& step, bool boardHash, std::vector<unsigned char>& out);
+void encodeEpisodeEnd(std::uint32_t finalScore, std::uint32_t stepCount, std::vector<unsigned char>& out);
+
+// Retornam false em fim de arquivo ou formato invalido.
+bool readHeader(std::istream& in, std::uint32_t& flags);
+bool readEpisode(std::istream& in, bool boardHash, EpisodeRecord& record);
+
+} // namespace tetris_env::trace
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <limits>
+
+#include "tetris/Types.hpp"
+#include "tetris_env/Action.hpp"
+#include "tetris_env/Bitboard.hpp"
+#include "tetris_env/BoardHeuristic.hpp"
+#include "tetris_env/StepResult.hpp"
+#include "tetris_env/TetrisEnv.hpp"
+
+namespace tetris_env {
+
+struct GreedyRolloutStep {
+    Action action{};
+    StepResult result{};
+    BoardFeatures before{};
+    BoardFeatures after{};
+};
+
+struct GreedyPlacement {
+    Action action{};
+    tetris::ActivePiece landing{};
+    double value = -std::numeric_limits<double>::infinity();
+    int lines = 0;
+    BoardFeatures after{};
+    bool found = false;
+};
+
+// Melhor jogada greedy num bitboard: avalia a peca ativa e, se holdCandidateId >= 0, a peca
+// que entraria com hold (partindo do spawn). Retorna false quando nao ha jogada valida.
+bool findGreedyPlacement(const bitboard::Rows& rows,
+                         const BoardFeatures& before,
+                         const tetris::ActivePiece& active,
+                         int holdCandidateId,
+                         GreedyPlacement& best);
+
+// Passo de rollout greedy sem alocacao: gera as jogadas na mesma ordem de getValidActions,
+// avalia os pos-estados num bitboard local (mesmo criterio e desempate do GreedyAgent) e aplica
+// a melhor em env. Retorna false quando nao ha jogada valida.
+bool applyGreedyRolloutStep(TetrisEnv& env, GreedyRolloutStep& out);
+
+} // namespace tetris_env
@@ -12,6 +12,10 @@ namespace tetris {
 // relative to the current working directory.
 std::optional<std::filesystem::path> findMctsConfigPath(const std::string& agentDir = "mcts_rollout");
 
+// Applies a single "key: value" MCTS setting. Returns false for unknown keys and invalid values
+// (params is left untouched in that case).
+bool applyMctsParam(const std::string& key, const std::string& value, ::MctsParams& params);
+
 // Loads MctsParams from the given YAML file (simple key: value format).
 bool loadMctsParamsFromYaml(const std::filesystem::path& filepath, ::MctsParams& params);
 
@@ -1,10 +1,14 @@
 #pragma once
 
 #include <array>
+#include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <optional>
 #include <random>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
@@ -12,8 +16,9 @@
 #include "tetris/EngineConfig.hpp"
 #include "tetris_env/TetrisEnv.hpp"
 #include "tetris_env/StepResult.hpp"
+#include "tetris_env/TranspositionStore.hpp"
+#include "tetris_env/TreeDump.hpp"
 
-class GreedyAgent;
 namespace tetris_env {
 struct BoardFeatures;
 }
@@ -28,12 +33,25 @@ enum class MctsValueFunction {
     GreedyHeuristic
 };
 
+enum class MctsLeafEvaluation {
+    Rollout,   // playout completo ate maxDepth com a politica de rollout
+    Heuristic, // valor estatico do pos-estado da folha, sem playout
+    Blend      // playout curto (leafRolloutDepth) seguido do valor estatico
+};
+
+enum class MctsExpansion {
+    Random,             // acao nao testada escolhida uniformemente
+    ProgressiveWidening // acoes ordenadas pela heuristica greedy e liberadas conforme as visitas
+};
+
 struct MctsParams {
     int iterations = 0;
     int maxDepth = 0;
     double exploration = 0.0;
     int threads = 1;
     std::optional<std::uint32_t> seed{};
+    // Reprodutivel: RNGs dos workers derivados de (seed, jogada, worker), sem orcamentos de tempo.
+    bool deterministic = false;
     std::optional<int> scoreLimit{};
     std::optional<double> timeLimitSeconds{};
 
@@ -41,15 +59,109 @@ struct MctsParams {
     MctsValueFunction valueFunction = MctsValueFunction::ScoreDelta;
     bool useTranspositionTable = false;
     std::size_t ttMaxEntries = 0; // 0 = usar um default interno razoavel
+    bool ttPersistAcrossEpisodes = false; // mantem a TT entre episodios do mesmo agente
+    std::string ttFile;                   // arquivo binario carregado na construcao e gravado ao fim de cada episodio
+
+    double moveTimeMs = 0.0; // >0: busca ate o deadline da jogada (iterations deixa de ser o limite)
+    bool earlyStop = false;  // encerra quando a acao mais visitada nao pode mais ser ultrapassada
+
+    // Controlador adaptativo: escala o orcamento base (iterations ou moveTimeMs) pela criticidade
+    // do tabuleiro; o que sobra em jogadas faceis fica guardado para as perigosas.
+    bool adaptiveBudget = false;
+    double budgetMinScale = 0.25;
+    double budgetMaxScale = 3.0;
+    std::optional<long long> episodeIterationBudget{};  // teto de iteracoes por episodio (modo iterations)
+    std::optional<double> episodeTimeBudgetSeconds{};   // teto de tempo de busca por episodio (modo moveTimeMs)
+
+    // Progressive widening: um no com N visitas pode ter ate max(1, pwConstant * N^pwAlpha) filhos.
+    MctsExpansion expansion = MctsExpansion::Random;
+    double pwConstant = 1.0;
+    double pwAlpha = 0.5;
+    bool usePuctPriors = false;    // selecao PUCT com priors softmax da heuristica (so com widening)
+    double priorTemperature = 1.0;
+
+    MctsLeafEvaluation leafEvaluation = MctsLeafEvaluation::Rollout;
+    int leafRolloutDepth = 2;      // passos de playout antes do valor estatico (modo Blend)
+    double leafValueWeight = 1.0;  // escala do valor estatico na unidade da recompensa
+    double nodeMemoryMb = 0.0;     // teto de memoria por arvore (0 = sem limite); poda folhas pouco visitadas
+    bool useRave = false;          // mistura estatisticas AMAF por jogada na selecao UCT
+    double raveK = 100.0;          // equivalencia do RAVE: beta = sqrt(k / (3n + k))
+    int leafRollouts = 1;          // rollouts simultaneos por folha (>1 usa o BatchRolloutSimulator)
+
+    // Malha aberta: cada iteracao sorteia as pecas alem da fila visivel e os nos guardam
+    // estatisticas por caminho de jogadas (desliga a TT). Com reuseTree a subarvore da jogada
+    // escolhida continua valida na proxima decisao.
+    bool openLoop = false;
+    bool reuseTree = false;
+    // GUI: continua buscando no estado previsto enquanto a jogada e exibida (ver ponder).
+    bool ponder = false;
+
+    // Mede o tempo de cada fase da busca (selecao, expansao, rollout, backprop); os contadores
+    // de MctsSearchStats sao sempre preenchidos.
+    bool telemetry = false;
+
+    // Dump binario das arvores de cada decisao (formato em TreeDump.hpp), gravado em segundo plano.
+    std::string treeDumpFile;
+    int treeDumpTopN = 5;       // filhos mais visitados mantidos por no
+    int treeDumpDepth = 3;      // profundidade maxima a partir da raiz
+    bool treeDumpBoards = false; // grava o tabuleiro de cada no (+40 bytes por no)
+};
+
+// Contadores de uma busca; em MctsMoveStats::search vem somados entre os workers.
+struct MctsSearchStats {
+    int maxTreeDepth = 0;        // maior profundidade de folha atingida na arvore
+    long long treeDepthSum = 0;  // soma das profundidades de folha (media = soma / iteracoes)
+    long long nodesAllocated = 0;
+    long long ttHits = 0;        // nos novos semeados por uma entrada da TT
+    long long ttInserts = 0;
+    long long ttRejects = 0;     // insercoes recusadas com a TT cheia
+    double selectionMs = 0.0;    // tempos por fase: so com MctsParams::telemetry
+    double expansionMs = 0.0;
+    double rolloutMs = 0.0;
+    double backpropMs = 0.0;
 };
 
+// Resumo da ultima decisao tomada pelo agente (preenchido por chooseAction).
+struct MctsMoveStats {
+    int iterations = 0;
+    double elapsedMs = 0.0;
+    bool stoppedEarly = false;
+    double criticality = 0.0; // 0 = tabuleiro tranquilo, 1 = critico (so com adaptiveBudget)
+    double budgetScale = 1.0; // fracao do orcamento base concedida a esta jogada
+    // Pico de memoria das arvores, somado entre as threads (que buscam ao mesmo tempo).
+    std::size_t peakNodes = 0;
+    std::size_t peakNodeBytes = 0;
+    int prunedNodes = 0;
+
+    int moveIndex = 0; // 1 na primeira jogada do episodio
+    MctsSearchStats search{};
+    // Desequilibrio entre os workers da jogada.
+    int workers = 0;
+    int minWorkerIterations = 0;
+    int maxWorkerIterations = 0;
+    double minWorkerMs = 0.0;
+    double maxWorkerMs = 0.0;
+};
+
+using MctsTelemetryCallback = std::function<void(const MctsMoveStats&)>;
+
 class MctsRolloutAgent : public Agent {
 public:
     explicit MctsRolloutAgent(MctsParams params = MctsParams());
 
     Action chooseAction(const TetrisEnv& env) override;
+    // Busca sem orcamento no estado esperado apos a jogada escolhida, ate stop virar true. O
+    // trabalho fica para o proximo chooseAction: a arvore (malha aberta) e/ou a TT. Nao roda
+    // junto com chooseAction.
+    void ponder(const TetrisEnv& predicted, const std::atomic<bool>& stop);
     void onEpisodeStart() override;
-    void onEpisodeEnd() override {}
+    void onEpisodeEnd() override;
+
+    const MctsMoveStats& lastMoveStats() const { return lastMoveStats_; }
+    // Chamado ao fim de cada chooseAction com as estatisticas da jogada, na thread que decidiu.
+    void setTelemetryCallback(MctsTelemetryCallback callback) { telemetryCallback_ = std::move(callback); }
+    // Episodio gravado no dump da arvore; sem chamada, conta os onEpisodeStart deste agente.
+    void setEpisodeIndex(int index) { episodeIndex_ = index; }
 
 private:
     struct Node {
@@ -58,15 +170,37 @@ private:
 
         int visits = 0;
         double totalValue = 0.0;
+        int seedVisits = 0; // parte de visits que veio da TT; visits - seedVisits = visitas desta busca
 
         bool terminal = false;
+        bool inherited = false; // veio da arvore da jogada anterior (malha aberta com reuseTree)
+        double prior = 0.0;
+        int placementKey = -1; // (peca, rotacao, coluna) da jogada vinda do pai, para o AMAF
+        int amafVisits = 0;
+        double amafValue = 0.0;
         std::vector<Action> untriedActions;
+        std::vector<double> untriedPriors; // paralelo a untriedActions (so com widening)
         std::vector<int> children;
     };
 
     struct SearchResult {
         std::vector<int> visits;
         std::vector<double> totalValue;
+        std::vector<int> searchVisits; // so as visitas desta busca (sem as semeadas pela TT)
+        int iterations = 0;
+        bool stoppedEarly = false;
+        std::size_t peakNodes = 0;
+        std::size_t peakBytes = 0; // estimativa: vetores de nos/chaves + listas de acoes/filhos
+        int prunedNodes = 0;
+        double elapsedMs = 0.0;
+        MctsSearchStats stats{};
+    };
+
+    // Limites de uma chamada de runSearch: numero de iteracoes, deadline e/ou sinal de parada.
+    struct SearchBudget {
+        int iterations = 0; // <=0 com deadline ou stop definido = sem limite de iteracoes
+        std::optional<std::chrono::steady_clock::time_point> deadline{};
+        const std::atomic<bool>* stop = nullptr;
     };
 
     struct StateKey {
@@ -92,32 +226,99 @@ private:
     struct TranspositionEntry {
         int visits = 0;
         double totalValue = 0.0;
+        // Parte de visits/totalValue que ja esta no tt_file (lida dele ou gravada por este agente).
+        int savedVisits = 0;
+        double savedValue = 0.0;
     };
 
     using TranspositionTable = std::unordered_map<StateKey, TranspositionEntry, StateKeyHash>;
 
-    double evalScoreDelta(const StepResult& r) const;
-    double evalGreedyHeuristic(const tetris_env::BoardFeatures& before,
-                               const tetris_env::BoardFeatures& after,
-                               const StepResult& r) const;
-    // Para GreedyHeuristic, os ponteiros de features devem ser validos (nao nulos).
-    // Para ScoreDelta, os ponteiros sao ignorados e podem ser nulos.
-    double stepValue(const StepResult& r,
-                     const tetris_env::BoardFeatures* beforeFeatures,
-                     const tetris_env::BoardFeatures* afterFeatures) const;
+    // Estado do controlador adaptativo ao longo do episodio (unidade: iteracoes ou ms).
+    struct BudgetState {
+        double bank = 0.0;
+        double spent = 0.0;
+    };
+
+    struct MoveBudget {
+        int iterations = 0;
+        double moveTimeMs = 0.0;
+    };
+
+    // Nucleo da busca especializado em politica de rollout e funcao de valor; a combinacao
+    // e escolhida uma vez por chooseAction (selectSearch).
+    template <MctsRolloutPolicy Policy, MctsValueFunction Value>
     SearchResult runSearch(const TetrisEnv& env,
                            const std::vector<Action>& rootActions,
-                           int iterations,
+                           const SearchBudget& budget,
                            std::mt19937& rng,
-                           TranspositionTable* table);
-    Action rolloutAction(const TetrisEnv& sim,
-                         const std::vector<Action>& validActions,
-                         std::mt19937& rng,
-                         GreedyAgent& greedyPolicy) const;
+                           TranspositionTable* table,
+                           std::vector<Node>& nodes);
+    using SearchFn = SearchResult (MctsRolloutAgent::*)(const TetrisEnv&,
+                                                         const std::vector<Action>&,
+                                                         const SearchBudget&,
+                                                         std::mt19937&,
+                                                         TranspositionTable*,
+                                                         std::vector<Node>&);
+    SearchFn selectSearch() const;
+    bool usesTimeBudget() const;
+    std::uint32_t workerSeed(int worker);
+    static std::size_t nodeFootprint(const Node& node);
+    int pruneLeaves(std::vector<Node>& nodes,
+                    std::vector<int>& freeSlots,
+                    std::size_t& liveBytes,
+                    std::size_t targetBytes) const;
+    void backpropagateAmaf(std::vector<Node>& nodes,
+                           int leafIndex,
+                           int leafDepth,
+                           const std::vector<int>& played,
+                           double value) const;
     StateKey makeKey(const TetrisEnv& env) const;
+    static std::uint64_t stableKeyHash(const StateKey& key);
+    std::optional<TranspositionEntry> storedEntry(const StateKey& key) const;
+    bool seedFromTransposition(TranspositionTable* table,
+                               std::size_t tableLimit,
+                               const StateKey& key,
+                               Node& node) const;
+    bool rootDecided(const std::vector<Node>& nodes, int remainingIterations) const;
+    std::vector<SearchResult> runWorkers(const TetrisEnv& env,
+                                         const std::vector<Action>& rootActions,
+                                         int workerCount,
+                                         const SearchBudget& budget);
+    bool retainsTrees() const;
+    void prepareTrees(const TetrisEnv& env, const std::vector<Action>& rootActions, int workerCount);
+    void rememberTrees(const TetrisEnv& root, const std::optional<Action>& played);
+    bool reusableTree(const TetrisEnv& env) const;
+    void dumpTrees(const TetrisEnv& env, const Action& chosen) const;
+    void appendDumpNode(const std::vector<Node>& nodes,
+                        int index,
+                        int depth,
+                        const TetrisEnv* state,
+                        std::vector<tetris_env::treedump::NodeRecord>& out) const;
+    void rerootTree(std::vector<Node>& nodes, const TetrisEnv& env, const std::vector<Action>& rootActions) const;
+    void orderByHeuristic(const TetrisEnv& state, Node& node) const;
+    bool canExpand(const Node& node) const;
+    int rolloutDepthLimit(int leafDepth) const;
+    double stateCriticality(const TetrisEnv& env) const;
+    MoveBudget planMoveBudget(const TetrisEnv& env);
+    void settleMoveBudget();
 
     MctsParams params_;
     std::mt19937 rng_;
+    int moveIndex_ = 0;
+    int episodeIndex_ = 0;
     std::size_t ttMaxEntries_ = 0;
     TranspositionTable transpositionTable_;
+    tetris_env::TranspositionStore store_;
+    MctsMoveStats lastMoveStats_{};
+    MctsTelemetryCallback telemetryCallback_{};
+    std::shared_ptr<tetris_env::treedump::Writer> treeDump_;
+    BudgetState budgetState_{};
+
+    // Arvores de cada worker guardadas para a proxima jogada (reuseTree/ponder) e o estado que
+    // ela deve encontrar: turno e tabuleiro, mais a jogada a descer a partir da raiz guardada
+    // (vazia quando a raiz ja e esse estado).
+    std::vector<std::vector<Node>> trees_;
+    std::optional<Action> reuseAction_{};
+    int reuseTurn_ = -1;
+    tetris::Board reuseBoard_{};
 };
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <vector>
+
+namespace tetris {
+
+struct MoveLatencySummary {
+    int moves = 0;
+    double p50Ms = 0.0;
+    double p90Ms = 0.0;
+    double p99Ms = 0.0;
+    double maxMs = 0.0;
+};
+
+// Computes nearest-rank percentiles of per-move decision latencies (milliseconds).
+MoveLatencySummary summarizeMoveLatencies(std::vector<double> samplesMs);
+
+} // namespace tetris
@@ -1,15 +1,47 @@
 #pragma once
 
+#include <filesystem>
 #include <string>
+#include <vector>
 
 #include "tetris_env/EpisodeReport.hpp"
+#include "tetris_env/MctsRolloutAgent.hpp"
 
 namespace tetris {
 
+// Header line (with trailing newline) of the per-run episode CSV.
+extern const char* const kEpisodeCsvHeader;
+
 // Builds a run identifier timestamp in the format YYYYMMDD_HH_MM_SS.
 std::string makeRunIdTimestamp();
 
+// agents/<agentDir>/run_<runId><suffix><extension>
+std::filesystem::path runFilePath(const std::string& runId,
+                                  const std::string& agentDir,
+                                  const std::string& filenameSuffix,
+                                  const std::string& extension);
+
+// Appends the CSV row (with trailing newline) of the episode report to out.
+void formatEpisodeCsvRow(const EpisodeReport& rep, std::string& out);
+
+// Parses a row written by formatEpisodeCsvRow (without the newline). Returns false on a malformed
+// or truncated row.
+bool parseEpisodeCsvRow(const std::string& line, EpisodeReport& rep);
+
+// Appends one JSON line per MCTS move of the episode to out.
+void formatMoveTelemetryJsonl(const std::string& runId,
+                              int episodeIndex,
+                              const std::vector<MctsMoveStats>& moves,
+                              std::string& out);
+
 // Appends the episode report to agents/<agentDir>/run_<runId><suffix>.csv, creating the file with header if needed.
 void appendEpisodeReportToRunFile(const EpisodeReport& rep, const std::string& agentDir, const std::string& filenameSuffix = "");
 
+// Appends one JSON object per MCTS move of the episode to agents/<agentDir>/run_<runId><suffix>_telemetry.jsonl.
+void appendMoveTelemetryToRunFile(const std::string& runId,
+                                  int episodeIndex,
+                                  const std::vector<MctsMoveStats>& moves,
+                                  const std::string& agentDir,
+                                  const std::string& filenameSuffix = "");
+
 } // namespace tetris
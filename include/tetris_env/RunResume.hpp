@@ -0,0 +1,39 @@
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "tetris_env/EpisodeReport.hpp"
+
+namespace tetris {
+
+// Episodes recovered from an interrupted run by resumeRunFiles.
+struct ResumedRunFiles {
+    std::vector<std::optional<EpisodeReport>> reports; // per episode (index - 1); empty if not completed
+    std::vector<int> missingEpisodes;                  // 1-based, ascending: episodes to run again
+    int droppedRows = 0;                               // malformed, truncated or repeated CSV rows
+};
+
+// Replaces the content of path through a temporary file and a rename.
+bool rewriteFile(const std::filesystem::path& path, std::string_view content);
+
+// Keeps only the telemetry lines (.jsonl) of completed episodes (done[episode - 1]); lines of
+// episodes that were running at the interruption would be repeated when they run again.
+bool resumeTelemetry(const std::filesystem::path& path, const std::vector<bool>& done);
+
+// Same filter for the trace (.ttrace), one record per episode; a record truncated at the end
+// (interrupted while writing) is dropped as well.
+bool resumeTrace(const std::filesystem::path& path, const std::vector<bool>& done);
+
+// Reloads the valid rows of the run CSV (the checkpoint), rewrites it without a row cut by the
+// interruption and filters the telemetry and trace files to the same episodes. Missing files
+// count as empty. Returns false if a file cannot be read or rewritten.
+bool resumeRunFiles(const std::filesystem::path& csvPath,
+                    const std::filesystem::path& telemetryPath,
+                    const std::filesystem::path& tracePath,
+                    int episodes,
+                    ResumedRunFiles& out);
+
+} // namespace tetris
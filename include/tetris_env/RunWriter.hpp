@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "tetris_env/EpisodeReport.hpp"
+#include "tetris_env/MctsRolloutAgent.hpp"
+
+namespace tetris {
+
+// Background writer for batch results. Producers push items onto a lock-free stack and return
+// at once; a single writer thread takes everything pushed so far in one exchange, formats it,
+// writes through file handles kept open per path and flushes once per batch of items.
+//
+// With columnar output every run CSV also gets a .tcol file, written from the rows handed to
+// closeRun (sorted by episode, including rows resumed from an earlier process). Each column is stored contiguously so analysis
+// tools can memory-map the file and read columns as plain arrays. Layout (little-endian):
+//   header, 64 bytes:  char magic[8] = "TETRCOL1", u32 version, u32 columnCount, u64 rowCount,
+//                      u64 metaOffset, u64 metaSize, zero padding
+//   column directory:  columnCount x 56 bytes { char name[32] (NUL padded), u32 type,
+//                      u32 width, u64 offset, u64 reserved }; type 0 = i64, 1 = f64,
+//                      2 = fixed-width NUL-padded text
+//   column data:       rowCount * width bytes per column, each column 8-byte aligned
+//   metadata:          "key=value\n" lines with run_id, agent_name, mode_name and agent_config
+class RunWriter {
+public:
+    explicit RunWriter(bool columnar = false);
+    // Drains the queue, writes pending .tcol files and closes everything.
+    ~RunWriter();
+    RunWriter(const RunWriter&) = delete;
+    RunWriter& operator=(const RunWriter&) = delete;
+
+    // Row of agents/<agentDir>/run_<runId><suffix>.csv (header added when the file is new).
+    void appendEpisodeReport(const EpisodeReport& rep, const std::string& agentDir, const std::string& filenameSuffix);
+    // Lines of agents/<agentDir>/run_<runId><suffix>_telemetry.jsonl.
+    void appendMoveTelemetry(const std::string& runId,
+                             int episodeIndex,
+                             std::vector<MctsMoveStats> moves,
+                             const std::string& agentDir,
+                             const std::string& filenameSuffix);
+    // Appends one encoded episode (tetris_env::trace) to agents/<agentDir>/run_<runId><suffix>.ttrace;
+    // a new file gets the trace header with `flags` first.
+    void appendEpisodeTrace(const std::string& runId,
+                            std::vector<unsigned char> bytes,
+                            std::uint32_t flags,
+                            const std::string& agentDir,
+                            const std::string& filenameSuffix);
+    // No more rows for this run file: closes its handles and, in columnar mode, writes the .tcol
+    // with every row of the run.
+    void closeRun(const std::string& runId,
+                  const std::string& agentDir,
+                  const std::string& filenameSuffix,
+                  std::vector<EpisodeReport> rows);
+
+private:
+    struct Item;
+
+    void push(Item* item);
+    void run();
+    void process(Item& item);
+    std::ofstream* fileFor(const std::filesystem::path& path, std::string_view headerIfNew);
+    void writeColumnar(const std::filesystem::path& csvPath, const std::vector<EpisodeReport>& rows);
+
+    const bool columnar_;
+    std::atomic<Item*> head_{nullptr};
+    std::atomic<std::uint32_t> signal_{0};
+    std::atomic<bool> stop_{false};
+    std::thread thread_;
+
+    // Owned by the writer thread.
+    std::map<std::filesystem::path, std::ofstream> files_;
+    std::vector<std::ofstream*> dirty_;
+};
+
+} // namespace tetris
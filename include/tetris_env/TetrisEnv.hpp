@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <optional>
 #include <vector>
 
@@ -13,6 +14,13 @@ public:
     TetrisEnv();
 
     void reset();
+    void reset(std::uint32_t seed); // reinicia com a sequencia de pecas fixada por seed
+    // Como reset(seed), mas a sequencia de pecas nao depende das jogadas (hold): agentes diferentes
+    // com a mesma seed recebem as mesmas pecas na mesma ordem.
+    void resetFixedStream(std::uint32_t seed);
+    // Vira uma copia de source com as pecas alem da fila visivel sorteadas de novo por seed, sem
+    // copiar nem semear o mt19937 do jogo (amostras da malha aberta do MCTS).
+    void resampleFrom(const TetrisEnv& source, std::uint32_t seed);
     StepResult step(const Action& action);
     TetrisEnv clone() const;
 
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace tetris_env {
+
+// Tabela de transposicao persistida em arquivo binario: cabecalho fixo seguido de uma tabela
+// de enderecamento aberto (sondagem linear) indexada pelo hash de 64 bits do estado. A carga
+// mapeia o arquivo em memoria (mmap em POSIX; no Windows le o arquivo inteiro), entao abrir
+// tem custo constante e as consultas leem direto do mapeamento. Pode ser consultada por varias
+// threads ao mesmo tempo; em POSIX o mapeamento e compartilhado e ve as gravacoes de save().
+class TranspositionStore {
+public:
+    struct Entry {
+        int visits = 0;
+        double totalValue = 0.0;
+    };
+
+    TranspositionStore() = default;
+    ~TranspositionStore();
+    TranspositionStore(const TranspositionStore&) = delete;
+    TranspositionStore& operator=(const TranspositionStore&) = delete;
+    TranspositionStore(TranspositionStore&& other) noexcept;
+    TranspositionStore& operator=(TranspositionStore&& other) noexcept;
+
+    // Retorna false se o arquivo nao existe ou nao tem o formato esperado.
+    bool open(const std::filesystem::path& path);
+    void close();
+
+    bool isOpen() const { return slots_ != nullptr; }
+    std::size_t size() const { return count_; }
+    std::optional<Entry> find(std::uint64_t hash) const;
+
+    // Soma deltas (visitas e valor acumulados desde a ultima gravacao) as entradas de path, no
+    // proprio arquivo, com um lock exclusivo (mutex no processo e flock em <path>.lock entre
+    // processos); agentes, threads e processos que dividem o arquivo nao perdem as atualizacoes
+    // uns dos outros. O custo e proporcional aos deltas, nao ao arquivo. Um arquivo novo e criado
+    // com capacidade para maxEntries entradas; a de um arquivo existente nao muda.
+    static bool save(const std::filesystem::path& path,
+                     const std::vector<std::pair<std::uint64_t, Entry>>& deltas,
+                     std::size_t maxEntries);
+
+    // Sondagem maxima a partir da posicao do hash. Com a janela cheia (ou o limite de entradas
+    // atingido) as entradas dela envelhecem: visitas e valor caem pela metade, e a menos visitada
+    // da lugar ao delta se tiver menos visitas que ele.
+    static constexpr std::uint64_t kProbeWindow = 16;
+
+private:
+    struct Slot;
+
+    const Slot* slots_ = nullptr;
+    std::uint64_t capacity_ = 0;
+    std::size_t count_ = 0;
+
+    void* mapping_ = nullptr;
+    std::size_t mappingSize_ = 0;
+    std::vector<unsigned char> buffer_; // usado quando nao ha mmap
+};
+
+} // namespace tetris_env
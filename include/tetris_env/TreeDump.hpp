@@ -0,0 +1,84 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "tetris_env/Action.hpp"
+#include "tetris_env/Bitboard.hpp"
+
+// Dump binario das arvores de busca (little-endian, como a maquina que gravou).
+//
+// Arquivo: magic "TETRTREE", u32 versao, u32 flags (bit 0: nos trazem o tabuleiro).
+// Registro por jogada: u32 episodio, u32 jogada, u8 acao escolhida, u8 workers; para cada
+// worker, u32 quantidade de nos e os nos em pre-ordem. No: u8 acao, u8 filhos gravados,
+// u32 visitas, f32 valor medio e, com a flag, kHeight linhas de u16 do tabuleiro.
+namespace tetris_env::treedump {
+
+constexpr std::uint32_t kVersion = 1;
+constexpr std::uint32_t kFlagBoards = 1u;
+constexpr std::uint8_t kNoAction = 0xFF; // raiz
+
+// rotacao (2 bits) | hold (1 bit) | targetX + 3 (4 bits)
+std::uint8_t packAction(const Action& action);
+Action unpackAction(std::uint8_t packed);
+
+struct NodeRecord {
+    std::uint8_t action = kNoAction;
+    std::uint8_t childCount = 0;
+    std::uint32_t visits = 0;
+    float meanValue = 0.0f;
+    bitboard::Rows board{};
+};
+
+struct MoveRecord {
+    std::uint32_t episode = 0;
+    std::uint32_t move = 0;
+    std::uint8_t chosenAction = kNoAction;
+    std::vector<std::vector<NodeRecord>> workers; // pre-ordem, raiz primeiro
+};
+
+void encodeMove(const MoveRecord& record, bool boards, std::vector<unsigned char>& out);
+
+// Retornam false em fim de arquivo ou formato invalido.
+bool readHeader(std::istream& in, std::uint32_t& flags);
+bool readMove(std::istream& in, bool boards, MoveRecord& record);
+
+// Grava os registros numa thread propria: a busca so codifica o registro e enfileira.
+class Writer {
+public:
+    Writer() = default;
+    ~Writer();
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+
+    // Writer unico por caminho no processo, compartilhado entre agentes. O arquivo e truncado
+    // so na primeira abertura; agentes criados depois continuam acrescentando registros.
+    static std::shared_ptr<Writer> shared(const std::filesystem::path& path, std::uint32_t flags);
+
+    // Cria o arquivo com cabecalho ou, com append, acrescenta ao existente.
+    bool open(const std::filesystem::path& path, std::uint32_t flags, bool append = false);
+    bool isOpen() const { return thread_.joinable(); }
+    void enqueue(std::vector<unsigned char> bytes);
+    // Espera a fila esvaziar e fecha o arquivo.
+    void close();
+
+private:
+    void run();
+
+    std::ofstream file_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<std::vector<unsigned char>> queue_;
+    bool quit_ = false;
+    std::thread thread_;
+};
+
+} // namespace tetris_env::treedump
@@ -0,0 +1,223 @@
+#include "tetris_env/BatchRolloutSimulator.hpp"
+
+#include <algorithm>
+#include <array>
+
+#include "tetris/Game.hpp"
+#include "tetris_env/GreedyRolloutKernel.hpp"
+
+namespace tetris_env {
+namespace {
+
+using namespace bitboard;
+
+// 4 rotacoes x 10 colunas, para a peca ativa e a do hold.
+constexpr std::size_t kMaxPlacements = 2 * 4 * kWidth;
+
+struct Placement {
+    tetris::ActivePiece landing{};
+    bool useHold = false;
+};
+
+std::uint64_t nextRandom(std::uint64_t& state) {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 2685821657736338717ULL;
+}
+
+int randomBelow(std::uint64_t& state, int bound) {
+    return static_cast<int>(((nextRandom(state) >> 32) * static_cast<std::uint64_t>(bound)) >> 32);
+}
+
+tetris::ActivePiece spawnPiece(int id) {
+    tetris::ActivePiece piece{};
+    piece.id = id;
+    piece.rotation = 0;
+    piece.origin = tetris::Game::spawnOrigin();
+    return piece;
+}
+
+void collectPlacements(const Rows& rows, const tetris::ActivePiece& start, bool useHold,
+                       std::array<Placement, kMaxPlacements>& out, std::size_t& count) {
+    if (start.id < 0 || !fits(rows, start.id, start.rotation, start.origin.x, start.origin.y)) {
+        return;
+    }
+    for (int rotation = 0; rotation < 4; ++rotation) {
+        const Shape& shape = shapeOf(start.id, rotation);
+        for (int targetX = -shape.minX; targetX <= kWidth - 1 - shape.maxX; ++targetX) {
+            tetris::ActivePiece landing{};
+            if (simulateLanding(rows, start, rotation, targetX, landing)) {
+                out[count++] = Placement{landing, useHold};
+            }
+        }
+    }
+}
+
+} // namespace
+
+BatchRolloutSimulator::BatchRolloutSimulator(int lanes) : lanes_(std::max(1, lanes)) {
+    const auto count = static_cast<std::size_t>(lanes_);
+    rows_.resize(count);
+    active_.resize(count);
+    hold_.resize(count);
+    alive_.resize(count);
+    cursor_.resize(count);
+    rngState_.resize(count);
+    reward_.resize(count);
+}
+
+void BatchRolloutSimulator::load(const TetrisEnv& env, int steps, std::mt19937& rng) {
+    const tetris::Game& game = env.game();
+    const Rows rows = rowsFromBoard(env.getBoard());
+    const std::vector<int> known = game.queuePreview(static_cast<std::size_t>(tetris::engine_cfg::queuePreviewCount));
+    const int active = game.activePieceId();
+    const int hold = game.hasHoldPiece() ? game.holdPiece() : -1;
+    canHoldFirst_ = game.canHold();
+
+    // Cada passo consome uma peca da fila; o primeiro hold com slot vazio consome mais uma.
+    sequenceStride_ = known.size() + static_cast<std::size_t>(std::max(0, steps)) + 2;
+    sequence_.resize(static_cast<std::size_t>(lanes_) * sequenceStride_);
+
+    for (int lane = 0; lane < lanes_; ++lane) {
+        const auto l = static_cast<std::size_t>(lane);
+        rows_[l] = rows;
+        active_[l] = static_cast<std::int8_t>(active);
+        hold_[l] = static_cast<std::int8_t>(hold);
+        alive_[l] = 1;
+        cursor_[l] = 0;
+        reward_[l] = 0.0;
+        std::uint64_t state = (static_cast<std::uint64_t>(rng()) << 32) | static_cast<std::uint64_t>(rng());
+        rngState_[l] = state != 0 ? state : 0x9E3779B97F4A7C15ULL;
+
+        std::int8_t* sequence = sequence_.data() + l * sequenceStride_;
+        std::size_t filled = 0;
+        int last = -1;
+        for (int id : known) {
+            sequence[filled++] = static_cast<std::int8_t>(id);
+            last = id;
+        }
+        // Aproximacao do Bag: saco de 7 embaralhado evitando repetir a ultima peca enfileirada.
+        while (filled < sequenceStride_) {
+            std::array<std::int8_t, kPieceCount> bag{0, 1, 2, 3, 4, 5, 6};
+            for (int i = kPieceCount - 1; i > 0; --i) {
+                std::swap(bag[static_cast<std::size_t>(i)],
+                          bag[static_cast<std::size_t>(randomBelow(rngState_[l], i + 1))]);
+            }
+            if (bag[0] == last) {
+                std::swap(bag[0], bag[1]);
+            }
+            for (std::size_t i = 0; i < bag.size() && filled < sequenceStride_; ++i) {
+                sequence[filled++] = bag[i];
+            }
+            last = sequence[filled - 1];
+        }
+    }
+}
+
+template <bool Greedy>
+void BatchRolloutSimulator::stepLane(int lane, bool holdAllowed, bool heuristicValue) {
+    const auto l = static_cast<std::size_t>(lane);
+    Rows& rows = rows_[l];
+    const std::int8_t* sequence = sequence_.data() + l * sequenceStride_;
+
+    const tetris::ActivePiece start = spawnPiece(active_[l]);
+    int holdCandidate = -1;
+    if (holdAllowed) {
+        holdCandidate = hold_[l] >= 0 ? hold_[l] : sequence[cursor_[l]];
+    }
+
+    BoardFeatures before{};
+    if (Greedy || heuristicValue) {
+        before = featuresOf(rows);
+    }
+
+    Placement chosen{};
+    if constexpr (Greedy) {
+        GreedyPlacement best{};
+        if (!findGreedyPlacement(rows, before, start, holdCandidate, best)) {
+            alive_[l] = 0;
+            return;
+        }
+        chosen = Placement{best.landing, best.action.useHold};
+    } else {
+        std::array<Placement, kMaxPlacements> placements;
+        std::size_t count = 0;
+        collectPlacements(rows, start, false, placements, count);
+        if (holdCandidate >= 0) {
+            collectPlacements(rows, spawnPiece(holdCandidate), true, placements, count);
+        }
+        if (count == 0) {
+            alive_[l] = 0;
+            return;
+        }
+        chosen = placements[static_cast<std::size_t>(randomBelow(rngState_[l], static_cast<int>(count)))];
+    }
+
+    if (chosen.useHold) {
+        if (hold_[l] < 0) {
+            ++cursor_[l];
+        }
+        hold_[l] = active_[l];
+    }
+
+    const int lines = lockAndClear(rows, chosen.landing);
+    active_[l] = sequence[cursor_[l]++];
+    const bool done = !fits(rows, active_[l], 0, tetris::Game::spawnOrigin().x, tetris::Game::spawnOrigin().y);
+    if (done) {
+        alive_[l] = 0;
+    }
+
+    const int scoreDelta = lineScore(lines);
+    if (heuristicValue) {
+        const StepResult r{lines, lines, scoreDelta, done};
+        reward_[l] += evaluateGreedyStep(before, featuresOf(rows), r);
+    } else {
+        reward_[l] += static_cast<double>(scoreDelta);
+    }
+}
+
+template <bool Greedy>
+double BatchRolloutSimulator::run(const TetrisEnv& env, int steps, bool heuristicValue, double leafWeight,
+                                  std::mt19937& rng) {
+    if (env.isGameOver() || !env.game().hasActivePiece()) {
+        return 0.0;
+    }
+    load(env, steps, rng);
+
+    for (int step = 0; step < steps; ++step) {
+        const bool holdAllowed = step > 0 || canHoldFirst_;
+        int alive = 0;
+        for (int lane = 0; lane < lanes_; ++lane) {
+            if (alive_[static_cast<std::size_t>(lane)] != 0) {
+                stepLane<Greedy>(lane, holdAllowed, heuristicValue);
+                alive += alive_[static_cast<std::size_t>(lane)];
+            }
+        }
+        if (alive == 0) {
+            break;
+        }
+    }
+
+    double total = 0.0;
+    for (int lane = 0; lane < lanes_; ++lane) {
+        const auto l = static_cast<std::size_t>(lane);
+        if (leafWeight != 0.0 && alive_[l] != 0) {
+            reward_[l] += leafWeight * evaluateBoardState(featuresOf(rows_[l]));
+        }
+        total += reward_[l];
+    }
+    return total / static_cast<double>(lanes_);
+}
+
+double BatchRolloutSimulator::runRandom(const TetrisEnv& env, int steps, bool heuristicValue, double leafWeight,
+                                        std::mt19937& rng) {
+    return run<false>(env, steps, heuristicValue, leafWeight, rng);
+}
+
+double BatchRolloutSimulator::runGreedy(const TetrisEnv& env, int steps, bool heuristicValue, double leafWeight,
+                                        std::mt19937& rng) {
+    return run<true>(env, steps, heuristicValue, leafWeight, rng);
+}
+
+} // namespace tetris_env
@@ -1,16 +1,28 @@
 #include "tetris_env/BoardHeuristic.hpp"
 
+#include <array>
 #include <cmath>
-#include <vector>
+
+#include "tetris/EngineConfig.hpp"
 
 namespace tetris_env {
+namespace {
+
+constexpr double wLines = 1.0;
+constexpr double wHoles = 4.0;
+constexpr double wTotalHeight = 0.5;
+constexpr double wBumpiness = 0.3;
+constexpr double wNewHoles = 2.0;
+constexpr double wScore = 0.01;
+
+} // namespace
 
 BoardFeatures computeBoardFeatures(const TetrisEnv& env) {
     const auto& board = env.getBoard();
     const int width = env.getBoardWidth();
     const int height = env.getBoardHeight();
 
-    std::vector<int> heights(static_cast<std::size_t>(width), 0);
+    std::array<int, tetris::engine_cfg::fieldWidth> heights{};
     int holes = 0;
 
     const auto& grid = board.data();
@@ -62,19 +74,10 @@ double evaluateGreedyStep(const BoardFeatures& before,
     const int linesCleared = stepResult.linesCleared;
     const int holesDelta = after.holes - before.holes;
 
-    const double wLines = 1.0;
-    const double wHoles = 4.0;
-    const double wTotalHeight = 0.5;
-    const double wBumpiness = 0.3;
-    const double wNewHoles = 2.0;
-    const double wScore = 0.01;
-
     double value = 0.0;
     value += wLines * static_cast<double>(linesCleared);
     value += wScore * static_cast<double>(stepResult.scoreDelta);
-    value -= wHoles * static_cast<double>(after.holes);
-    value -= wTotalHeight * static_cast<double>(after.totalHeight);
-    value -= wBumpiness * static_cast<double>(after.bumpiness);
+    value += evaluateBoardState(after);
     if (holesDelta > 0) {
         value -= wNewHoles * static_cast<double>(holesDelta);
     }
@@ -82,4 +85,12 @@ double evaluateGreedyStep(const BoardFeatures& before,
     return value;
 }
 
+double evaluateBoardState(const BoardFeatures& features) {
+    double value = 0.0;
+    value -= wHoles * static_cast<double>(features.holes);
+    value -= wTotalHeight * static_cast<double>(features.totalHeight);
+    value -= wBumpiness * static_cast<double>(features.bumpiness);
+    return value;
+}
+
 } // namespace tetris_env
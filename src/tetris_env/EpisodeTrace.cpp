@@ -0,0 +1,118 @@
+#include "tetris_env/EpisodeTrace.hpp"
+
+#include <array>
+#include <cstring>
+
+namespace tetris_env::trace {
+namespace {
+
+constexpr std::array<char, 8> kMagic{'T', 'E', 'T', 'R', 'T', 'R', 'C', 'E'};
+
+template <typename T>
+void put(std::vector<unsigned char>& out, T value) {
+    const std::size_t offset = out.size();
+    out.resize(offset + sizeof(T));
+    std::memcpy(out.data() + offset, &value, sizeof(T));
+}
+
+template <typename T>
+bool get(std::istream& in, T& value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+void putVarint(std::vector<unsigned char>& out, std::uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<unsigned char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<unsigned char>(value));
+}
+
+bool getVarint(std::istream& in, std::uint32_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        const int byte = in.get();
+        if (byte == std::istream::traits_type::eof()) {
+            return false;
+        }
+        value |= static_cast<std::uint32_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+std::uint32_t hashBoard(const bitboard::Rows& rows) {
+    std::uint32_t hash = 2166136261u;
+    for (std::uint16_t row : rows) {
+        hash = (hash ^ (row & 0xFFu)) * 16777619u;
+        hash = (hash ^ (row >> 8)) * 16777619u;
+    }
+    return hash;
+}
+
+void encodeHeader(std::uint32_t flags, std::vector<unsigned char>& out) {
+    out.insert(out.end(), kMagic.begin(), kMagic.end());
+    put(out, kVersion);
+    put(out, flags);
+}
+
+void encodeEpisodeStart(std::uint32_t episode, std::uint32_t seed, std::vector<unsigned char>& out) {
+    putVarint(out, episode);
+    putVarint(out, seed);
+}
+
+void encodeStep(const StepRecord& step, bool boardHash, std::vector<unsigned char>& out) {
+    out.push_back(static_cast<unsigned char>((step.piece & 7) | ((step.linesCleared & 7) << 3)));
+    out.push_back(step.action);
+    putVarint(out, step.scoreDelta);
+    putVarint(out, step.latencyUs);
+    if (boardHash) {
+        put(out, step.boardHash);
+    }
+}
+
+void encodeEpisodeEnd(std::uint32_t finalScore, std::uint32_t stepCount, std::vector<unsigned char>& out) {
+    out.push_back(kEndMarker);
+    putVarint(out, finalScore);
+    putVarint(out, stepCount);
+}
+
+bool readHeader(std::istream& in, std::uint32_t& flags) {
+    std::array<char, 8> magic{};
+    std::uint32_t version = 0;
+    if (!in.read(magic.data(), magic.size()) || magic != kMagic || !get(in, version) || version != kVersion) {
+        return false;
+    }
+    return get(in, flags);
+}
+
+bool readEpisode(std::istream& in, bool boardHash, EpisodeRecord& record) {
+    record.steps.clear();
+    if (!getVarint(in, record.episode) || !getVarint(in, record.seed)) {
+        return false;
+    }
+    while (true) {
+        const int first = in.get();
+        if (first == std::istream::traits_type::eof()) {
+            return false;
+        }
+        if (first == kEndMarker) {
+            std::uint32_t stepCount = 0;
+            return getVarint(in, record.finalScore) && getVarint(in, stepCount) && stepCount == record.steps.size();
+        }
+        StepRecord step{};
+        step.piece = static_cast<std::uint8_t>(first & 7);
+        step.linesCleared = static_cast<std::uint8_t>((first >> 3) & 7);
+        if (!get(in, step.action) || !getVarint(in, step.scoreDelta) || !getVarint(in, step.latencyUs) ||
+            (boardHash && !get(in, step.boardHash))) {
+            return false;
+        }
+        record.steps.push_back(step);
+    }
+}
+
+} // namespace tetris_env::trace
@@ -0,0 +1,89 @@
+#include "tetris_env/GreedyRolloutKernel.hpp"
+
+#include "tetris/Game.hpp"
+
+namespace tetris_env {
+namespace {
+
+using namespace bitboard;
+
+void scorePiece(const Rows& rows, const BoardFeatures& before, const tetris::ActivePiece& start, bool useHold,
+                GreedyPlacement& best) {
+    if (start.id < 0 || !fits(rows, start.id, start.rotation, start.origin.x, start.origin.y)) {
+        return;
+    }
+
+    for (int rotation = 0; rotation < 4; ++rotation) {
+        const Shape& shape = shapeOf(start.id, rotation);
+        for (int targetX = -shape.minX; targetX <= kWidth - 1 - shape.maxX; ++targetX) {
+            tetris::ActivePiece landing{};
+            if (!simulateLanding(rows, start, rotation, targetX, landing)) {
+                continue;
+            }
+
+            Rows after = rows;
+            const int lines = lockAndClear(after, landing);
+            const BoardFeatures afterFeatures = featuresOf(after);
+            const StepResult r{lines, lines, lineScore(lines), false};
+            const double value = evaluateGreedyStep(before, afterFeatures, r);
+            if (value > best.value) {
+                best.value = value;
+                best.action = Action{rotation, landing.origin.x, useHold};
+                best.landing = landing;
+                best.lines = lines;
+                best.after = afterFeatures;
+                best.found = true;
+            }
+        }
+    }
+}
+
+} // namespace
+
+bool findGreedyPlacement(const bitboard::Rows& rows,
+                         const BoardFeatures& before,
+                         const tetris::ActivePiece& active,
+                         int holdCandidateId,
+                         GreedyPlacement& best) {
+    best = GreedyPlacement{};
+    scorePiece(rows, before, active, false, best);
+
+    if (holdCandidateId >= 0) {
+        tetris::ActivePiece holdPiece{};
+        holdPiece.id = holdCandidateId;
+        holdPiece.rotation = 0;
+        holdPiece.origin = tetris::Game::spawnOrigin();
+        scorePiece(rows, before, holdPiece, true, best);
+    }
+    return best.found;
+}
+
+bool applyGreedyRolloutStep(TetrisEnv& env, GreedyRolloutStep& out) {
+    if (env.isGameOver()) {
+        return false;
+    }
+    const tetris::Game& game = env.game();
+    if (!game.hasActivePiece()) {
+        return false;
+    }
+
+    const Rows rows = rowsFromBoard(env.getBoard());
+    const BoardFeatures before = featuresOf(rows);
+    int holdCandidateId = -1;
+    if (game.canHold()) {
+        holdCandidateId = game.hasHoldPiece() ? game.holdPiece() : game.nextPieceId();
+    }
+
+    GreedyPlacement best{};
+    if (!findGreedyPlacement(rows, before, game.activePiece(), holdCandidateId, best)) {
+        return false;
+    }
+
+    out.action = best.action;
+    out.before = before;
+    out.after = best.after;
+    out.result = env.step(best.action);
+    return true;
+}
+
+} // namespace tetris_env
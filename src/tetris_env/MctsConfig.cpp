@@ -36,6 +36,15 @@ bool tryParseInt(const std::string& value, int& out) {
     }
 }
 
+bool tryParseLongLong(const std::string& value, long long& out) {
+    try {
+        out = std::stoll(value);
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
 bool tryParseDouble(const std::string& value, double& out) {
     try {
         out = std::stod(value);
@@ -115,6 +124,304 @@ std::optional<std::filesystem::path> findMctsConfigPath(const std::string& agent
     return std::nullopt;
 }
 
+bool applyMctsParam(const std::string& key, const std::string& value, ::MctsParams& params) {
+    if (key == "iterations") {
+        int parsed = params.iterations;
+        if (tryParseInt(value, parsed) && parsed > 0) {
+            params.iterations = parsed;
+            return true;
+        }
+        return false;
+    } else if (key == "maxDepth" || key == "rollout_depth") {
+        int parsed = params.maxDepth;
+        if (tryParseInt(value, parsed) && parsed > 0) {
+            params.maxDepth = parsed;
+            return true;
+        }
+        return false;
+    } else if (key == "exploration" || key == "uct_c") {
+        double parsed = params.exploration;
+        if (tryParseDouble(value, parsed) && parsed > 0.0) {
+            params.exploration = parsed;
+            return true;
+        }
+        return false;
+    } else if (key == "threads" || key == "num_threads") {
+        int parsed = params.threads;
+        if (tryParseInt(value, parsed) && parsed > 0) {
+            params.threads = parsed;
+            return true;
+        }
+        return false;
+    } else if (key == "seed") {
+        std::uint32_t parsedSeed{};
+        if (tryParseUint32(value, parsedSeed)) {
+            params.seed = parsedSeed;
+            return true;
+        }
+        return false;
+    } else if (key == "score_limit" || key == "maxScore" || key == "max_score") {
+        int parsed = 0;
+        if (tryParseInt(value, parsed) && parsed > 0) {
+            params.scoreLimit = parsed;
+            return true;
+        }
+        return false;
+    } else if (key == "time_limit_seconds" || key == "time_limit" || key == "max_time_seconds") {
+        double parsed = 0.0;
+        if (tryParseDouble(value, parsed) && parsed > 0.0) {
+            params.timeLimitSeconds = parsed;
+            return true;
+        }
+        return false;
+    } else if (key == "rollout_policy") {
+        const std::string lower = toLower(value);
+        if (lower == "greedy") {
+            params.rolloutPolicy = MctsRolloutPolicy::Greedy;
+            return true;
+        } else if (lower == "random") {
+            params.rolloutPolicy = MctsRolloutPolicy::Random;
+            return true;
+        }
+        return false;
+    } else if (key == "reward_mode") {
+        const std::string lower = toLower(value);
+        if (lower == "score") {
+            params.valueFunction = MctsValueFunction::ScoreDelta;
+            return true;
+        } else if (lower == "greedy") {
+            params.valueFunction = MctsValueFunction::GreedyHeuristic;
+            return true;
+        }
+        return false;
+    } else if (key == "use_transposition_table" || key == "use_tt") {
+        bool parsed = false;
+        if (tryParseBool(value, parsed)) {
+            params.useTranspositionTable = parsed;
+            return true;
+        }
+        return false;
+    } else if (key == "tt_max_entries") {
+        int parsed = 0;
+        if (tryParseInt(value, parsed) && parsed >= 0) {
+            params.ttMaxEntries = static_cast<std::size_t>(parsed);
+            return true;
+        }
+        return false;
+    } else if (key == "tt_persist_across_episodes") {
+        bool parsed = false;
+        if (tryParseBool(value, parsed)) {
+            params.ttPersistAcrossEpisodes = parsed;
+            return true;
+        }
+        return false;
+    } else if (key == "tt_file") {
+        params.ttFile = value;
+        return true;
+    } else if (key == "move_time_ms") {
+        double parsed = 0.0;
+        if (tryParseDouble(value, parsed) && parsed >= 0.0) {
+            params.moveTimeMs = parsed;
+            return true;
+        }
+        return false;
+    } else if (key == "early_stop") {
+        bool parsed = false;
+        if (tryParseBool(value, parsed)) {
+            params.earlyStop = parsed;
+            return true;
+        }
+        return false;
+    } else if (key == "adaptive_budget") {
+        bool parsed = false;
+        if (tryParseBool(value, parsed)) {
+            params.adaptiveBudget = parsed;
+            return true;
+        }
+        return false;
+    } else if (key == "budget_min_scale") {
+        double parsed = 0.0;
+        if (tryParseDouble(value, parsed) && parsed > 0.0) {
+            params.budgetMinScale = parsed;
+            return true;
+        }
+        return false;
+    } else if (key == "budget_max_scale") {
+        double parsed = 0.0;
+        if (tryParseDouble(value, parsed) && parsed > 0.0) {
+            params.budgetMaxScale = parsed;
+            return true;
+        }
+        return false;
+    } else if (key == "episode_iteration_budget") {
+        long long parsed = 0;
+        if (tryParseLongLong(value, parsed) && parsed > 0) {
+            params.episodeIterationBudget = parsed;
+            return true;
+        }
+        return false;
+    } else if (key == "expansion") {
+        const std::string lower = toLower(value);
+        if (lower == "random") {
+            params.expansion = MctsExpansion::Random;
+            return true;
+        } else if (lower == "progressive" || lower == "progressive_widening") {
+            params.expansion = MctsExpansion::ProgressiveWidening;
+            return true;
+        }
+        return false;
+    } else if (key == "pw_c") {
+        double parsed = 0.0;
+        if (tryParseDouble(value, parsed) && parsed > 0.0) {
+            params.pwConstant = parsed;
+            return true;
+        }
+        return false;
+    } else if (key == "pw_alpha") {
+        double parsed = 0.0;
+        if (tryParseDouble(value, parsed) && parsed >= 0.0) {
+            params.pwAlpha = parsed;
+            return true;
+        }
+        return false;
+    } else if (key == "puct") {
+        bool parsed = false;
+        if (tryParseBool(value, parsed)) {
+            params.usePuctPriors = parsed;
+            return true;
+        }
+        return false;
+    } else if (key == "prior_temperature") {
+        double parsed = 0.0;
+        if (tryParseDouble(value, parsed) && parsed > 0.0) {
+            params.priorTemperature = parsed;
+            return true;
+        }
+        return false;
+    } else if (key == "leaf_eval") {
+        const std::string lower = toLower(value);
+        if (lower == "rollout") {
+            params.leafEvaluation = MctsLeafEvaluation::Rollout;
+            return true;
+        } else if (lower == "heuristic") {
+            params.leafEvaluation = MctsLeafEvaluation::Heuristic;
+            return true;
+        } else if (lower == "blend") {
+            params.leafEvaluation = MctsLeafEvaluation::Blend;
+            return true;
+        }
+        return false;
+    } else if (key == "leaf_rollout_depth") {
+        int parsed = 0;
+        if (tryParseInt(value, parsed) && parsed >= 0) {
+            params.leafRolloutDepth = parsed;
+            return true;
+        }
+        return false;
+    } else if (key == "leaf_value_weight") {
+        double parsed = 0.0;
+        if (tryParseDouble(value, parsed) && parsed >= 0.0) {
+            params.leafValueWeight = parsed;
+            return true;
+        }
+        return false;
+    } else if (key == "deterministic") {
+        bool parsed = false;
+        if (tryParseBool(value, parsed)) {
+            params.deterministic = parsed;
+            return true;
+        }
+        return false;
+    } else if (key == "node_memory_mb") {
+        double parsed = 0.0;
+        if (tryParseDouble(value, parsed) && parsed >= 0.0) {
+            params.nodeMemoryMb = parsed;
+            return true;
+        }
+        return false;
+    } else if (key == "rave") {
+        bool parsed = false;
+        if (tryParseBool(value, parsed)) {
+            params.useRave = parsed;
+            return true;
+        }
+        return false;
+    } else if (key == "rave_k") {
+        double parsed = 0.0;
+        if (tryParseDouble(value, parsed) && parsed > 0.0) {
+            params.raveK = parsed;
+            return true;
+        }
+        return false;
+    } else if (key == "leaf_rollouts") {
+        int parsed = 0;
+        if (tryParseInt(value, parsed) && parsed >= 1) {
+            params.leafRollouts = parsed;
+            return true;
+        }
+        return false;
+    } else if (key == "open_loop") {
+        bool parsed = false;
+        if (tryParseBool(value, parsed)) {
+            params.openLoop = parsed;
+            return true;
+        }
+        return false;
+    } else if (key == "reuse_tree") {
+        bool parsed = false;
+        if (tryParseBool(value, parsed)) {
+            params.reuseTree = parsed;
+            return true;
+        }
+        return false;
+    } else if (key == "ponder") {
+        bool parsed = false;
+        if (tryParseBool(value, parsed)) {
+            params.ponder = parsed;
+            return true;
+        }
+        return false;
+    } else if (key == "telemetry") {
+        bool parsed = false;
+        if (tryParseBool(value, parsed)) {
+            params.telemetry = parsed;
+            return true;
+        }
+        return false;
+    } else if (key == "tree_dump_file") {
+        params.treeDumpFile = value;
+        return true;
+    } else if (key == "tree_dump_top_n") {
+        int parsed = 0;
+        if (tryParseInt(value, parsed) && parsed >= 1) {
+            params.treeDumpTopN = parsed;
+            return true;
+        }
+        return false;
+    } else if (key == "tree_dump_depth") {
+        int parsed = 0;
+        if (tryParseInt(value, parsed) && parsed >= 0) {
+            params.treeDumpDepth = parsed;
+            return true;
+        }
+        return false;
+    } else if (key == "tree_dump_boards") {
+        bool parsed = false;
+        if (tryParseBool(value, parsed)) {
+            params.treeDumpBoards = parsed;
+            return true;
+        }
+        return false;
+    } else if (key == "episode_time_budget_seconds") {
+        double parsed = 0.0;
+        if (tryParseDouble(value, parsed) && parsed > 0.0) {
+            params.episodeTimeBudgetSeconds = parsed;
+            return true;
+        }
+    }
+    return false;
+}
+
 bool loadMctsParamsFromYaml(const std::filesystem::path& filepath, ::MctsParams& params) {
     std::ifstream file(filepath);
     if (!file.is_open()) {
@@ -149,68 +456,15 @@ bool loadMctsParamsFromYaml(const std::filesystem::path& filepath, ::MctsParams&
             continue;
         }
 
+        if (!applyMctsParam(key, value, params)) {
+            continue;
+        }
         if (key == "iterations") {
-            int parsed = params.iterations;
-            if (tryParseInt(value, parsed) && parsed > 0) {
-                params.iterations = parsed;
-                hasIterations = true;
-            }
+            hasIterations = true;
         } else if (key == "maxDepth" || key == "rollout_depth") {
-            int parsed = params.maxDepth;
-            if (tryParseInt(value, parsed) && parsed > 0) {
-                params.maxDepth = parsed;
-                hasMaxDepth = true;
-            }
+            hasMaxDepth = true;
         } else if (key == "exploration" || key == "uct_c") {
-            double parsed = params.exploration;
-            if (tryParseDouble(value, parsed) && parsed > 0.0) {
-                params.exploration = parsed;
-                hasExploration = true;
-            }
-        } else if (key == "threads" || key == "num_threads") {
-            int parsed = params.threads;
-            if (tryParseInt(value, parsed) && parsed > 0) {
-                params.threads = parsed;
-            }
-        } else if (key == "seed") {
-            std::uint32_t parsedSeed{};
-            if (tryParseUint32(value, parsedSeed)) {
-                params.seed = parsedSeed;
-            }
-        } else if (key == "score_limit" || key == "maxScore" || key == "max_score") {
-            int parsed = 0;
-            if (tryParseInt(value, parsed) && parsed > 0) {
-                params.scoreLimit = parsed;
-            }
-        } else if (key == "time_limit_seconds" || key == "time_limit" || key == "max_time_seconds") {
-            double parsed = 0.0;
-            if (tryParseDouble(value, parsed) && parsed > 0.0) {
-                params.timeLimitSeconds = parsed;
-            }
-        } else if (key == "rollout_policy") {
-            const std::string lower = toLower(value);
-            if (lower == "greedy") {
-                params.rolloutPolicy = MctsRolloutPolicy::Greedy;
-            } else if (lower == "random") {
-                params.rolloutPolicy = MctsRolloutPolicy::Random;
-            }
-        } else if (key == "reward_mode") {
-            const std::string lower = toLower(value);
-            if (lower == "score") {
-                params.valueFunction = MctsValueFunction::ScoreDelta;
-            } else if (lower == "greedy") {
-                params.valueFunction = MctsValueFunction::GreedyHeuristic;
-            }
-        } else if (key == "use_transposition_table" || key == "use_tt") {
-            bool parsed = false;
-            if (tryParseBool(value, parsed)) {
-                params.useTranspositionTable = parsed;
-            }
-        } else if (key == "tt_max_entries") {
-            int parsed = 0;
-            if (tryParseInt(value, parsed) && parsed >= 0) {
-                params.ttMaxEntries = static_cast<std::size_t>(parsed);
-            }
+            hasExploration = true;
         }
     }
 
@@ -254,6 +508,78 @@ std::string buildMctsConfigString(const ::MctsParams& params) {
         << " reward=" << rewardStr
         << " tt=" << (params.useTranspositionTable ? "on" : "off")
         << " tt_max_entries=" << params.ttMaxEntries;
+    if (params.useTranspositionTable && params.ttPersistAcrossEpisodes) {
+        oss << " tt_persist=on";
+    }
+    if (params.useTranspositionTable && !params.ttFile.empty()) {
+        oss << " tt_file=" << params.ttFile;
+    }
+    oss
+        << " move_time_ms=" << params.moveTimeMs
+        << " early_stop=" << (params.earlyStop ? "on" : "off")
+        << " adaptive_budget=" << (params.adaptiveBudget ? "on" : "off");
+    if (params.adaptiveBudget) {
+        oss << " budget_scale=" << params.budgetMinScale << ".." << params.budgetMaxScale
+            << " episode_budget=";
+        if (params.moveTimeMs > 0.0 && params.episodeTimeBudgetSeconds.has_value()) {
+            oss << *params.episodeTimeBudgetSeconds << 's';
+        } else if (params.moveTimeMs <= 0.0 && params.episodeIterationBudget.has_value()) {
+            oss << *params.episodeIterationBudget;
+        } else {
+            oss << "none";
+        }
+    }
+    if (params.expansion == MctsExpansion::ProgressiveWidening) {
+        oss << " expansion=progressive pw_c=" << params.pwConstant
+            << " pw_alpha=" << params.pwAlpha
+            << " puct=" << (params.usePuctPriors ? "on" : "off");
+        if (params.usePuctPriors) {
+            oss << " prior_temperature=" << params.priorTemperature;
+        }
+    } else {
+        oss << " expansion=random";
+    }
+    switch (params.leafEvaluation) {
+        case MctsLeafEvaluation::Heuristic:
+            oss << " leaf_eval=heuristic leaf_value_weight=" << params.leafValueWeight;
+            break;
+        case MctsLeafEvaluation::Blend:
+            oss << " leaf_eval=blend leaf_rollout_depth=" << params.leafRolloutDepth
+                << " leaf_value_weight=" << params.leafValueWeight;
+            break;
+        case MctsLeafEvaluation::Rollout:
+        default:
+            oss << " leaf_eval=rollout";
+            break;
+    }
+    if (params.deterministic) {
+        oss << " deterministic=on";
+    }
+    if (params.nodeMemoryMb > 0.0) {
+        oss << " node_memory_mb=" << params.nodeMemoryMb;
+    }
+    if (params.useRave) {
+        oss << " rave=on rave_k=" << params.raveK;
+    }
+    if (params.leafRollouts > 1) {
+        oss << " leaf_rollouts=" << params.leafRollouts;
+    }
+    if (params.openLoop) {
+        oss << " open_loop=on";
+        if (params.reuseTree) {
+            oss << " reuse_tree=on";
+        }
+    }
+    if (params.ponder) {
+        oss << " ponder=on";
+    }
+    if (params.telemetry) {
+        oss << " telemetry=on";
+    }
+    if (!params.treeDumpFile.empty()) {
+        oss << " tree_dump=" << params.treeDumpFile << " top_n=" << params.treeDumpTopN
+            << " depth=" << params.treeDumpDepth << (params.treeDumpBoards ? " boards=on" : "");
+    }
     return oss.str();
 }
 
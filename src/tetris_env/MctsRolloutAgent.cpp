@@ -1,6 +1,8 @@
 #include "tetris_env/MctsRolloutAgent.hpp"
 
 #include <algorithm>
+#include <bitset>
+#include <chrono>
 #include <cmath>
 #include <limits>
 #include <random>
@@ -9,11 +11,35 @@
 
 #include "tetris/EngineConfig.hpp"
 #include "tetris_env/BoardHeuristic.hpp"
-#include "tetris_env/GreedyAgent.hpp"
+#include "tetris_env/BatchRolloutSimulator.hpp"
+#include "tetris_env/GreedyRolloutKernel.hpp"
 
 namespace {
 
 constexpr std::size_t kDefaultTtEntries = 200000;
+constexpr std::size_t kDeadlineReserveNodes = 4096;
+constexpr int kEarlyStopCheckInterval = 8;
+
+// Normalizacao da criticidade do tabuleiro usada pelo orcamento adaptativo.
+constexpr double kCriticalHoles = 10.0;
+constexpr double kCriticalBumpiness = 30.0;
+constexpr double kMinMoveTimeMs = 1.0;
+
+// Malha aberta: enquanto o caminho consumiu menos pecas que isso, um no criado nesta busca so
+// viu pecas da fila visivel e todas as jogadas guardadas nele valem.
+constexpr int kKnownPieces = tetris::engine_cfg::queuePreviewCount;
+
+// Limite de memoria da arvore: ao estourar, poda folhas ate esta fracao do teto.
+constexpr int kFreeSlot = -2;
+constexpr double kPruneTargetFraction = 0.75;
+constexpr double kBytesPerMb = 1024.0 * 1024.0;
+// Limite de jogadas de um no (rotacoes x colunas x hold), usado para reservar folga sob o teto.
+constexpr std::size_t kMaxNodeActions = 4 * 16 * 2;
+
+// Chaves AMAF: (peca colocada, rotacao, coluna alvo deslocada para nao ficar negativa).
+constexpr int kPlacementColumns = 16;
+constexpr int kPlacementColumnOffset = 3;
+constexpr std::size_t kPlacementKeys = 7 * 4 * kPlacementColumns;
 
 bool actionsEqual(const Action& a, const Action& b) {
     return a.rotation == b.rotation && a.targetX == b.targetX && a.useHold == b.useHold;
@@ -27,8 +53,154 @@ Action randomAction(const std::vector<Action>& actions, std::mt19937& rng) {
     return actions[dist(rng)];
 }
 
+int heldPieceId(const tetris::Game& game) {
+    return game.hasHoldPiece() ? game.holdPiece() : game.nextPieceId();
+}
+
+int placementKey(int pieceId, const Action& action) {
+    const int column = action.targetX + kPlacementColumnOffset;
+    if (pieceId < 0 || pieceId >= 7 || column < 0 || column >= kPlacementColumns) {
+        return -1;
+    }
+    return (pieceId * 4 + (action.rotation & 3)) * kPlacementColumns + column;
+}
+
+// Deve ser chamada antes de aplicar a acao em sim.
+int placementKeyFor(const TetrisEnv& sim, const Action& action) {
+    const tetris::Game& game = sim.game();
+    return placementKey(action.useHold ? heldPieceId(game) : game.activePieceId(), action);
+}
+
+// Em malha aberta uma jogada guardada na arvore so vale se a peca correspondente da amostra
+// atual pousa na coluna pedida.
+bool actionApplicable(const tetris_env::bitboard::Rows& rows, const tetris::Game& game, const Action& action) {
+    if (!game.hasActivePiece()) {
+        return false;
+    }
+    tetris::ActivePiece start = game.activePiece();
+    if (action.useHold) {
+        if (!game.canHold()) {
+            return false;
+        }
+        start.id = heldPieceId(game);
+        start.rotation = 0;
+        start.origin = tetris::Game::spawnOrigin();
+    }
+    if (start.id < 0 ||
+        !tetris_env::bitboard::fits(rows, start.id, start.rotation, start.origin.x, start.origin.y)) {
+        return false;
+    }
+    tetris::ActivePiece landing{};
+    return tetris_env::bitboard::simulateLanding(rows, start, action.rotation & 3, action.targetX, landing);
+}
+
+// Indice de uma jogada nao testada aplicavel a amostra atual, ou -1. Com ordered segue a ordem
+// da heuristica (melhor no fim); senao a busca parte de uma posicao sorteada. Sem check todas
+// valem (estado ainda determinado pela fila visivel).
+int applicableUntried(const std::vector<Action>& untried,
+                      const tetris_env::bitboard::Rows& rows,
+                      const tetris::Game& game,
+                      bool ordered,
+                      bool check,
+                      std::mt19937& rng) {
+    const std::size_t count = untried.size();
+    if (count == 0) {
+        return -1;
+    }
+    std::size_t start = count - 1;
+    if (!ordered) {
+        std::uniform_int_distribution<std::size_t> dist(0, count - 1);
+        start = dist(rng);
+    }
+    for (std::size_t k = 0; k < count; ++k) {
+        const std::size_t i = (start + count - k) % count;
+        if (!check || actionApplicable(rows, game, untried[i])) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+// Aplica a acao e soma a recompensa do passo; com ScoreDelta nenhuma feature e calculada.
+template <MctsValueFunction Value>
+StepResult stepWithValue(TetrisEnv& sim, const Action& action, double& reward) {
+    if constexpr (Value == MctsValueFunction::GreedyHeuristic) {
+        const tetris_env::BoardFeatures before = tetris_env::computeBoardFeatures(sim);
+        const StepResult r = sim.step(action);
+        reward += tetris_env::evaluateGreedyStep(before, tetris_env::computeBoardFeatures(sim), r);
+        return r;
+    } else {
+        const StepResult r = sim.step(action);
+        reward += static_cast<double>(r.scoreDelta);
+        return r;
+    }
+}
+
+// Um passo da politica de rollout; retorna false quando nao ha jogada valida.
+// placedKey recebe a chave AMAF da jogada feita.
+template <MctsRolloutPolicy Policy, MctsValueFunction Value>
+bool rolloutStep(TetrisEnv& sim, std::mt19937& rng, double& reward, bool& done, int& placedKey) {
+    if constexpr (Policy == MctsRolloutPolicy::Greedy) {
+        // O kernel ja devolve as features antes/depois do passo escolhido.
+        const int activeId = sim.game().activePieceId();
+        const int holdId = heldPieceId(sim.game());
+        tetris_env::GreedyRolloutStep greedyStep{};
+        if (!tetris_env::applyGreedyRolloutStep(sim, greedyStep)) {
+            return false;
+        }
+        placedKey = placementKey(greedyStep.action.useHold ? holdId : activeId, greedyStep.action);
+        if constexpr (Value == MctsValueFunction::GreedyHeuristic) {
+            reward += tetris_env::evaluateGreedyStep(greedyStep.before, greedyStep.after, greedyStep.result);
+        } else {
+            reward += static_cast<double>(greedyStep.result.scoreDelta);
+        }
+        done = greedyStep.result.done;
+        return true;
+    } else {
+        const auto actions = sim.getValidActions();
+        if (actions.empty()) {
+            return false;
+        }
+        const Action action = randomAction(actions, rng);
+        placedKey = placementKeyFor(sim, action);
+        done = stepWithValue<Value>(sim, action, reward).done;
+        return true;
+    }
+}
+
 } // namespace
 
+std::uint64_t MctsRolloutAgent::stableKeyHash(const StateKey& key) {
+    // FNV-1a sobre os campos em ordem fixa: o valor nao muda entre execucoes nem builds.
+    std::uint64_t h = 14695981039346656037ULL;
+    auto mix = [&h](int value) {
+        const auto bits = static_cast<std::uint32_t>(value);
+        for (int shift = 0; shift < 32; shift += 8) {
+            h ^= (bits >> shift) & 0xFFu;
+            h *= 1099511628211ULL;
+        }
+    };
+
+    for (const auto& row : key.board) {
+        for (int cell : row) {
+            mix(cell);
+        }
+    }
+    mix(static_cast<int>(key.hasActive));
+    mix(key.activeId);
+    mix(key.rotation);
+    mix(key.originX);
+    mix(key.originY);
+    mix(static_cast<int>(key.canHold));
+    mix(static_cast<int>(key.hasHold));
+    mix(key.holdPiece);
+    mix(key.nextQueueCount);
+    for (int val : key.nextQueue) {
+        mix(val);
+    }
+    return h;
+}
+
 bool MctsRolloutAgent::StateKey::operator==(const StateKey& other) const {
     return board == other.board &&
            hasActive == other.hasActive &&
@@ -72,67 +244,189 @@ std::size_t MctsRolloutAgent::StateKeyHash::operator()(const StateKey& key) cons
 }
 
 MctsRolloutAgent::MctsRolloutAgent(MctsParams params) : params_(std::move(params)) {
-    if (params_.seed.has_value()) {
-        rng_.seed(*params_.seed);
+    if (params_.seed.has_value() || params_.deterministic) {
+        rng_.seed(params_.seed.value_or(0));
     } else {
         rng_.seed(std::random_device{}());
     }
 
     ttMaxEntries_ = params_.ttMaxEntries == 0 ? kDefaultTtEntries : params_.ttMaxEntries;
+    if (params_.useTranspositionTable && !params_.ttFile.empty()) {
+        store_.open(params_.ttFile);
+    }
+    if (!params_.treeDumpFile.empty()) {
+        treeDump_ = tetris_env::treedump::Writer::shared(
+            params_.treeDumpFile, params_.treeDumpBoards ? tetris_env::treedump::kFlagBoards : 0u);
+    }
 }
 
 void MctsRolloutAgent::onEpisodeStart() {
-    if (params_.useTranspositionTable) {
+    if (params_.useTranspositionTable && !params_.ttPersistAcrossEpisodes) {
         transpositionTable_.clear();
     }
+    budgetState_ = BudgetState{};
+    moveIndex_ = 0;
+    ++episodeIndex_;
+    trees_.clear();
+    reuseAction_.reset();
+    reuseTurn_ = -1;
+    if (params_.deterministic) {
+        rng_.seed(params_.seed.value_or(0));
+    }
 }
 
-double MctsRolloutAgent::evalScoreDelta(const StepResult& r) const {
-    return static_cast<double>(r.scoreDelta);
+void MctsRolloutAgent::onEpisodeEnd() {
+    if (!params_.useTranspositionTable || params_.ttFile.empty()) {
+        return;
+    }
+
+    // So o que o agente somou desde a leitura ou a ultima gravacao vai para o arquivo, que outros
+    // agentes ou processos podem ter atualizado nesse meio tempo.
+    std::vector<std::pair<std::uint64_t, tetris_env::TranspositionStore::Entry>> deltas;
+    deltas.reserve(transpositionTable_.size());
+    for (const auto& [key, entry] : transpositionTable_) {
+        const int visits = entry.visits - entry.savedVisits;
+        if (visits != 0) {
+            deltas.emplace_back(stableKeyHash(key),
+                                tetris_env::TranspositionStore::Entry{visits, entry.totalValue - entry.savedValue});
+        }
+    }
+    if (deltas.empty() || !tetris_env::TranspositionStore::save(params_.ttFile, deltas, ttMaxEntries_)) {
+        return;
+    }
+    for (auto& [key, entry] : transpositionTable_) {
+        entry.savedVisits = entry.visits;
+        entry.savedValue = entry.totalValue;
+    }
+    if (!store_.isOpen()) {
+        store_.open(params_.ttFile);
+    }
 }
 
-double MctsRolloutAgent::evalGreedyHeuristic(const tetris_env::BoardFeatures& before,
-                                             const tetris_env::BoardFeatures& after,
-                                             const StepResult& r) const {
-    return tetris_env::evaluateGreedyStep(before, after, r);
+std::optional<MctsRolloutAgent::TranspositionEntry> MctsRolloutAgent::storedEntry(const StateKey& key) const {
+    if (!store_.isOpen()) {
+        return std::nullopt;
+    }
+    const auto stored = store_.find(stableKeyHash(key));
+    if (!stored.has_value()) {
+        return std::nullopt;
+    }
+    return TranspositionEntry{stored->visits, stored->totalValue, stored->visits, stored->totalValue};
 }
 
-double MctsRolloutAgent::stepValue(const StepResult& r,
-                                   const tetris_env::BoardFeatures* beforeFeatures,
-                                   const tetris_env::BoardFeatures* afterFeatures) const {
-    switch (params_.valueFunction) {
-        case MctsValueFunction::ScoreDelta:
-            return evalScoreDelta(r);
-        case MctsValueFunction::GreedyHeuristic:
-            if (beforeFeatures != nullptr && afterFeatures != nullptr) {
-                return evalGreedyHeuristic(*beforeFeatures, *afterFeatures, r);
+bool MctsRolloutAgent::seedFromTransposition(TranspositionTable* table,
+                                             std::size_t tableLimit,
+                                             const StateKey& key,
+                                             Node& node) const {
+    TranspositionEntry seed{};
+    const auto it = table->find(key);
+    if (table == &transpositionTable_) {
+        if (it != table->end()) {
+            seed = it->second;
+        } else if (const auto stored = storedEntry(key)) {
+            seed = *stored;
+            if (table->size() < tableLimit) {
+                table->emplace(key, seed);
             }
-            return 0.0;
-        default:
-            return 0.0;
+        }
+    } else {
+        // Tabela local de um worker: soma o que ela tem as jogadas anteriores (tabela global,
+        // so lida durante a busca) ou, na falta delas, ao arquivo persistido.
+        const auto global = transpositionTable_.find(key);
+        if (global != transpositionTable_.end()) {
+            seed = global->second;
+        } else if (const auto stored = storedEntry(key)) {
+            seed = *stored;
+        }
+        if (it != table->end()) {
+            seed.visits += it->second.visits;
+            seed.totalValue += it->second.totalValue;
+        }
     }
+
+    if (seed.visits <= 0) {
+        return false;
+    }
+    node.visits = seed.visits;
+    node.totalValue = seed.totalValue;
+    node.seedVisits = seed.visits;
+    return true;
 }
 
-Action MctsRolloutAgent::rolloutAction(const TetrisEnv& sim,
-                                       const std::vector<Action>& validActions,
-                                       std::mt19937& rng,
-                                       GreedyAgent& greedyPolicy) const {
-    if (validActions.empty()) {
-        return Action{};
+bool MctsRolloutAgent::usesTimeBudget() const {
+    return params_.moveTimeMs > 0.0 && !params_.deterministic;
+}
+
+std::uint32_t MctsRolloutAgent::workerSeed(int worker) {
+    if (!params_.deterministic) {
+        return rng_();
     }
+    // Fluxo de cada worker depende so de (seed, jogada, worker), nao do consumo das jogadas anteriores.
+    std::seed_seq sequence{params_.seed.value_or(0), static_cast<unsigned int>(moveIndex_),
+                           static_cast<unsigned int>(worker)};
+    std::uint32_t value = 0;
+    sequence.generate(&value, &value + 1);
+    return value;
+}
+
+double MctsRolloutAgent::stateCriticality(const TetrisEnv& env) const {
+    const tetris_env::BoardFeatures f = tetris_env::computeBoardFeatures(env);
+    const double height = static_cast<double>(f.maxHeight) / static_cast<double>(env.getBoardHeight());
+    const double holes = std::min(1.0, static_cast<double>(f.holes) / kCriticalHoles);
+    const double bumpiness = std::min(1.0, static_cast<double>(f.bumpiness) / kCriticalBumpiness);
+    return std::clamp(0.6 * height + 0.3 * holes + 0.1 * bumpiness, 0.0, 1.0);
+}
 
-    if (params_.rolloutPolicy == MctsRolloutPolicy::Random) {
-        return randomAction(validActions, rng);
+MctsRolloutAgent::MoveBudget MctsRolloutAgent::planMoveBudget(const TetrisEnv& env) {
+    MoveBudget plan{params_.iterations, params_.moveTimeMs};
+    if (!params_.adaptiveBudget) {
+        return plan;
     }
 
-    Action chosen = greedyPolicy.chooseAction(sim);
-    for (const auto& candidate : validActions) {
-        if (actionsEqual(candidate, chosen)) {
-            return chosen;
-        }
+    const bool timeBudgeted = usesTimeBudget();
+    const double base = timeBudgeted ? params_.moveTimeMs : static_cast<double>(params_.iterations);
+    const double minScale = std::max(0.0, std::min(params_.budgetMinScale, 1.0));
+    const double maxScale = std::max(1.0, params_.budgetMaxScale);
+
+    const double criticality = stateCriticality(env);
+    double allotment = base * (minScale + (maxScale - minScale) * criticality);
+    if (allotment > base) {
+        // Acima do orcamento base so com o que foi economizado antes.
+        allotment = base + std::min(allotment - base, budgetState_.bank);
+    }
+
+    std::optional<double> episodeCap{};
+    if (timeBudgeted && params_.episodeTimeBudgetSeconds.has_value()) {
+        episodeCap = *params_.episodeTimeBudgetSeconds * 1000.0;
+    } else if (!timeBudgeted && params_.episodeIterationBudget.has_value()) {
+        episodeCap = static_cast<double>(*params_.episodeIterationBudget);
+    }
+    if (episodeCap.has_value()) {
+        // Teto do episodio esgotado: cada jogada fica com a fatia minima.
+        allotment = std::min(allotment, std::max(*episodeCap - budgetState_.spent, base * minScale));
+    }
+
+    lastMoveStats_.criticality = criticality;
+    lastMoveStats_.budgetScale = base > 0.0 ? allotment / base : 1.0;
+
+    if (timeBudgeted) {
+        plan.moveTimeMs = std::max(allotment, kMinMoveTimeMs);
+    } else {
+        plan.iterations = std::max(1, static_cast<int>(std::lround(allotment)));
+    }
+    return plan;
+}
+
+void MctsRolloutAgent::settleMoveBudget() {
+    if (!params_.adaptiveBudget) {
+        return;
     }
 
-    return randomAction(validActions, rng);
+    const bool timeBudgeted = usesTimeBudget();
+    const double base = timeBudgeted ? params_.moveTimeMs : static_cast<double>(params_.iterations);
+    const double used = timeBudgeted ? lastMoveStats_.elapsedMs : static_cast<double>(lastMoveStats_.iterations);
+    budgetState_.bank = std::max(0.0, budgetState_.bank + base - used);
+    budgetState_.spent += used;
 }
 
 MctsRolloutAgent::StateKey MctsRolloutAgent::makeKey(const TetrisEnv& env) const {
@@ -170,77 +464,509 @@ MctsRolloutAgent::StateKey MctsRolloutAgent::makeKey(const TetrisEnv& env) const
     return key;
 }
 
+bool MctsRolloutAgent::rootDecided(const std::vector<Node>& nodes, int remainingIterations) const {
+    const Node& root = nodes.front();
+    if (root.children.size() + root.untriedActions.size() < 2) {
+        return true;
+    }
+
+    // Acoes ainda nao expandidas contam como candidatas com zero visitas. So as visitas desta
+    // busca contam: as semeadas pela TT nao dizem o que as iteracoes restantes ainda podem mudar.
+    int best = 0;
+    int second = 0;
+    for (int childIndex : root.children) {
+        const Node& child = nodes[static_cast<std::size_t>(childIndex)];
+        const int v = child.visits - child.seedVisits;
+        if (v > best) {
+            second = best;
+            best = v;
+        } else if (v > second) {
+            second = v;
+        }
+    }
+
+    return best - second > remainingIterations;
+}
+
+bool MctsRolloutAgent::reusableTree(const TetrisEnv& env) const {
+    return reuseTurn_ >= 0 &&
+           env.getTurnNumber() == reuseTurn_ &&
+           env.getBoard().data() == reuseBoard_.data();
+}
+
+// Mantem so a subarvore da jogada escolhida, compactada com a nova raiz no indice 0. As
+// estatisticas dela continuam validas porque dependem do caminho de jogadas, nao das pecas.
+void MctsRolloutAgent::rerootTree(std::vector<Node>& nodes,
+                                  const TetrisEnv& env,
+                                  const std::vector<Action>& rootActions) const {
+    if (nodes.empty()) {
+        return;
+    }
+    int newRoot = -1;
+    for (int childIndex : nodes.front().children) {
+        if (actionsEqual(nodes[static_cast<std::size_t>(childIndex)].actionFromParent, *reuseAction_)) {
+            newRoot = childIndex;
+            break;
+        }
+    }
+    if (newRoot < 0) {
+        nodes.clear();
+        return;
+    }
+
+    std::vector<Node> kept;
+    kept.reserve(nodes.size());
+    kept.push_back(std::move(nodes[static_cast<std::size_t>(newRoot)]));
+    for (std::size_t head = 0; head < kept.size(); ++head) {
+        std::vector<int> children = std::move(kept[head].children);
+        kept[head].children.clear();
+        for (int childIndex : children) {
+            Node child = std::move(nodes[static_cast<std::size_t>(childIndex)]);
+            child.parent = static_cast<int>(head);
+            child.inherited = true;
+            kept[head].children.push_back(static_cast<int>(kept.size()));
+            kept.push_back(std::move(child));
+        }
+    }
+
+    // Na raiz as jogadas nao testadas passam a ser as validas para as pecas reais.
+    Node& root = kept.front();
+    root.parent = -1;
+    root.inherited = true;
+    root.actionFromParent = Action{};
+    root.terminal = false;
+    root.placementKey = -1;
+    root.untriedActions.clear();
+    root.untriedPriors.clear();
+    for (const Action& action : rootActions) {
+        const bool expanded = std::any_of(root.children.begin(), root.children.end(), [&](int childIndex) {
+            return actionsEqual(kept[static_cast<std::size_t>(childIndex)].actionFromParent, action);
+        });
+        if (!expanded) {
+            root.untriedActions.push_back(action);
+        }
+    }
+    if (params_.expansion == MctsExpansion::ProgressiveWidening) {
+        orderByHeuristic(env, root);
+    }
+    nodes = std::move(kept);
+}
+
+void MctsRolloutAgent::orderByHeuristic(const TetrisEnv& state, Node& node) const {
+    const std::size_t count = node.untriedActions.size();
+    if (count == 0) {
+        return;
+    }
+
+    const tetris_env::BoardFeatures before = tetris_env::computeBoardFeatures(state);
+    std::vector<double> values(count, 0.0);
+    for (std::size_t i = 0; i < count; ++i) {
+        TetrisEnv after = state.clone();
+        const StepResult r = after.step(node.untriedActions[i]);
+        values[i] = tetris_env::evaluateGreedyStep(before, tetris_env::computeBoardFeatures(after), r);
+    }
+
+    // Ordem crescente: a melhor acao fica no fim e sai primeiro com pop_back.
+    std::vector<std::size_t> order(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return values[a] < values[b];
+    });
+
+    const double temperature = params_.priorTemperature > 0.0 ? params_.priorTemperature : 1.0;
+    const double maxValue = values[order.back()];
+    double normalizer = 0.0;
+    for (double v : values) {
+        normalizer += std::exp((v - maxValue) / temperature);
+    }
+
+    std::vector<Action> sortedActions;
+    sortedActions.reserve(count);
+    node.untriedPriors.clear();
+    node.untriedPriors.reserve(count);
+    for (std::size_t idx : order) {
+        sortedActions.push_back(node.untriedActions[idx]);
+        node.untriedPriors.push_back(std::exp((values[idx] - maxValue) / temperature) / normalizer);
+    }
+    node.untriedActions = std::move(sortedActions);
+}
+
+int MctsRolloutAgent::rolloutDepthLimit(int leafDepth) const {
+    switch (params_.leafEvaluation) {
+        case MctsLeafEvaluation::Heuristic:
+            return leafDepth;
+        case MctsLeafEvaluation::Blend:
+            return std::min(params_.maxDepth, leafDepth + std::max(0, params_.leafRolloutDepth));
+        case MctsLeafEvaluation::Rollout:
+        default:
+            return params_.maxDepth;
+    }
+}
+
+bool MctsRolloutAgent::canExpand(const Node& node) const {
+    if (node.untriedActions.empty()) {
+        return false;
+    }
+    if (params_.expansion != MctsExpansion::ProgressiveWidening) {
+        return true;
+    }
+    const double limit = params_.pwConstant * std::pow(static_cast<double>(std::max(1, node.visits)), params_.pwAlpha);
+    return static_cast<double>(node.children.size()) < std::max(1.0, std::floor(limit));
+}
+
+std::size_t MctsRolloutAgent::nodeFootprint(const Node& node) {
+    return node.untriedActions.capacity() * sizeof(Action) +
+           node.untriedPriors.capacity() * sizeof(double) +
+           node.children.capacity() * sizeof(int);
+}
+
+int MctsRolloutAgent::pruneLeaves(std::vector<Node>& nodes,
+                                  std::vector<int>& freeSlots,
+                                  std::size_t& liveBytes,
+                                  std::size_t targetBytes) const {
+    // Filhos da raiz ficam sempre: deles sai o resultado da busca.
+    std::vector<int> leaves;
+    for (std::size_t i = 1; i < nodes.size(); ++i) {
+        const Node& n = nodes[i];
+        if (n.parent > 0 && n.children.empty()) {
+            leaves.push_back(static_cast<int>(i));
+        }
+    }
+    std::stable_sort(leaves.begin(), leaves.end(), [&nodes](int a, int b) {
+        return nodes[static_cast<std::size_t>(a)].visits < nodes[static_cast<std::size_t>(b)].visits;
+    });
+
+    const bool progressive = params_.expansion == MctsExpansion::ProgressiveWidening;
+    int pruned = 0;
+    for (int index : leaves) {
+        if (liveBytes <= targetBytes) {
+            break;
+        }
+        Node& leaf = nodes[static_cast<std::size_t>(index)];
+        Node& parent = nodes[static_cast<std::size_t>(leaf.parent)];
+
+        // A jogada volta para o pai e pode ser expandida de novo mais tarde.
+        liveBytes -= nodeFootprint(parent);
+        parent.children.erase(std::find(parent.children.begin(), parent.children.end(), index));
+        if (progressive) {
+            const auto pos = std::upper_bound(parent.untriedPriors.begin(), parent.untriedPriors.end(), leaf.prior);
+            const auto offset = pos - parent.untriedPriors.begin();
+            parent.untriedActions.insert(parent.untriedActions.begin() + offset, leaf.actionFromParent);
+            parent.untriedPriors.insert(pos, leaf.prior);
+        } else {
+            parent.untriedActions.push_back(leaf.actionFromParent);
+        }
+        liveBytes += nodeFootprint(parent);
+
+        liveBytes -= nodeFootprint(leaf);
+        leaf = Node{};
+        leaf.parent = kFreeSlot;
+        freeSlots.push_back(index);
+        ++pruned;
+    }
+    return pruned;
+}
+
+void MctsRolloutAgent::backpropagateAmaf(std::vector<Node>& nodes,
+                                         int leafIndex,
+                                         int leafDepth,
+                                         const std::vector<int>& played,
+                                         double value) const {
+    // Um no na profundidade d credita aos filhos toda jogada feita a partir dele (played[d..]).
+    std::bitset<kPlacementKeys> seen;
+    for (std::size_t i = static_cast<std::size_t>(leafDepth); i < played.size(); ++i) {
+        if (played[i] >= 0) {
+            seen.set(static_cast<std::size_t>(played[i]));
+        }
+    }
+
+    int current = leafIndex;
+    int depth = leafDepth;
+    while (current != -1) {
+        for (int childIndex : nodes[static_cast<std::size_t>(current)].children) {
+            Node& child = nodes[static_cast<std::size_t>(childIndex)];
+            if (child.placementKey >= 0 && seen.test(static_cast<std::size_t>(child.placementKey))) {
+                child.amafVisits += 1;
+                child.amafValue += value;
+            }
+        }
+        if (depth > 0) {
+            --depth;
+            const int key = played[static_cast<std::size_t>(depth)];
+            if (key >= 0) {
+                seen.set(static_cast<std::size_t>(key));
+            }
+        }
+        current = nodes[static_cast<std::size_t>(current)].parent;
+    }
+}
+
+MctsRolloutAgent::SearchFn MctsRolloutAgent::selectSearch() const {
+    const bool greedyRollout = params_.rolloutPolicy == MctsRolloutPolicy::Greedy;
+    if (params_.valueFunction == MctsValueFunction::GreedyHeuristic) {
+        return greedyRollout
+            ? &MctsRolloutAgent::runSearch<MctsRolloutPolicy::Greedy, MctsValueFunction::GreedyHeuristic>
+            : &MctsRolloutAgent::runSearch<MctsRolloutPolicy::Random, MctsValueFunction::GreedyHeuristic>;
+    }
+    return greedyRollout
+        ? &MctsRolloutAgent::runSearch<MctsRolloutPolicy::Greedy, MctsValueFunction::ScoreDelta>
+        : &MctsRolloutAgent::runSearch<MctsRolloutPolicy::Random, MctsValueFunction::ScoreDelta>;
+}
+
+template <MctsRolloutPolicy Policy, MctsValueFunction Value>
 MctsRolloutAgent::SearchResult MctsRolloutAgent::runSearch(const TetrisEnv& env,
                                                            const std::vector<Action>& rootActions,
-                                                           int iterations,
+                                                           const SearchBudget& budget,
                                                            std::mt19937& rng,
-                                                           TranspositionTable* table) {
+                                                           TranspositionTable* table,
+                                                           std::vector<Node>& nodes) {
     SearchResult result{};
     result.visits.assign(rootActions.size(), 0);
+    result.searchVisits.assign(rootActions.size(), 0);
     result.totalValue.assign(rootActions.size(), 0.0);
 
-    if (iterations <= 0 || params_.maxDepth <= 0) {
+    const bool hasDeadline = budget.deadline.has_value();
+    const bool stoppable = budget.stop != nullptr;
+    if ((!hasDeadline && !stoppable && budget.iterations <= 0) || params_.maxDepth <= 0) {
         return result;
     }
 
-    const bool useTranspositions = params_.useTranspositionTable && table != nullptr && ttMaxEntries_ > 0;
+    const bool unboundedIterations = (hasDeadline || stoppable) && budget.iterations <= 0;
+    const int iterations = unboundedIterations ? std::numeric_limits<int>::max() : budget.iterations;
+    const std::size_t reserveNodes = unboundedIterations
+        ? kDeadlineReserveNodes
+        : static_cast<std::size_t>(iterations) + 1;
+    const auto searchStart = std::chrono::steady_clock::now();
+
+    // Em malha aberta os nos representam caminhos de jogadas, nao estados exatos.
+    const bool openLoop = params_.openLoop;
+    const bool useTranspositions =
+        !openLoop && params_.useTranspositionTable && table != nullptr && ttMaxEntries_ > 0;
     const std::size_t tableLimit = useTranspositions ? ttMaxEntries_ : 0;
 
-    std::vector<Node> nodes;
-    nodes.reserve(static_cast<std::size_t>(iterations) + 1);
-    nodes.emplace_back();
+    // Memoria da arvore: capacidade dos vetores de nos e de chaves (um slot custa slotBytes) mais as
+    // listas de cada no vivo. growHeadroom cobre o que uma iteracao ainda pode somar: um no novo e
+    // as listas cheias de dois nos.
+    const std::size_t capBytes = params_.nodeMemoryMb > 0.0
+        ? static_cast<std::size_t>(params_.nodeMemoryMb * kBytesPerMb)
+        : 0;
+    const std::size_t slotBytes = sizeof(Node) + (useTranspositions ? sizeof(StateKey) : 0);
+    const std::size_t growHeadroom =
+        slotBytes + kMaxNodeActions * (2 * (sizeof(Action) + sizeof(double)) + sizeof(int));
+    const std::size_t pruneLimit = capBytes > growHeadroom ? capBytes - growHeadroom : 0;
+    const std::size_t pruneTarget = std::min(
+        pruneLimit, static_cast<std::size_t>(static_cast<double>(capBytes) * kPruneTargetFraction));
+
+    // Arvore nao vazia = subarvore reaproveitada da jogada anterior, com a raiz ja preparada.
+    const bool reused = !nodes.empty();
+    if (!reused) {
+        nodes.reserve(capBytes > 0 ? std::min(reserveNodes, capBytes / (2 * slotBytes) + 1) : reserveNodes);
+        nodes.emplace_back();
+    }
+    std::vector<int> freeSlots;
 
     std::vector<StateKey> nodeKeys;
+    auto containerBytes = [&nodes, &nodeKeys]() {
+        return nodes.capacity() * sizeof(Node) + nodeKeys.capacity() * sizeof(StateKey);
+    };
     if (useTranspositions) {
-        nodeKeys.reserve(static_cast<std::size_t>(iterations) + 1);
+        nodeKeys.reserve(nodes.capacity());
         nodeKeys.push_back(makeKey(env));
-        const auto it = table->find(nodeKeys.back());
-        if (it != table->end()) {
-            nodes.front().visits = it->second.visits;
-            nodes.front().totalValue = it->second.totalValue;
-        }
+        seedFromTransposition(table, tableLimit, nodeKeys.back(), nodes.front());
     }
 
     Node& root = nodes.front();
-    root.parent = -1;
-    root.actionFromParent = Action{};
-    root.terminal = false;
-    root.untriedActions = rootActions;
+    if (!reused) {
+        root.parent = -1;
+        root.actionFromParent = Action{};
+        root.terminal = false;
+        root.untriedActions = rootActions;
+    }
+
+    const bool rave = params_.useRave;
+    std::vector<int> played; // chave AMAF da jogada feita em cada profundidade da iteracao
+    played.reserve(static_cast<std::size_t>(params_.maxDepth));
+
+    const bool batchRollouts = params_.leafRollouts > 1;
+    tetris_env::BatchRolloutSimulator batch(batchRollouts ? params_.leafRollouts : 1);
+    const double leafWeight =
+        params_.leafEvaluation != MctsLeafEvaluation::Rollout ? params_.leafValueWeight : 0.0;
+
+    const bool progressive = params_.expansion == MctsExpansion::ProgressiveWidening;
+    const bool puct = progressive && params_.usePuctPriors;
+    if (progressive && !reused) {
+        orderByHeuristic(env, root);
+    }
+
+    std::size_t liveBytes = containerBytes();
+    for (const Node& n : nodes) {
+        liveBytes += nodeFootprint(n);
+    }
+    std::size_t liveNodes = nodes.size();
+    auto prune = [&](std::size_t targetBytes) {
+        const int pruned = pruneLeaves(nodes, freeSlots, liveBytes, targetBytes);
+        result.prunedNodes += pruned;
+        liveNodes -= static_cast<std::size_t>(pruned);
+    };
+    // Com teto, garante um slot para o no novo sem passar do teto. Os vetores so crescem ate o alvo
+    // da poda (a capacidade nao volta); com eles cheios, a poda libera slots das folhas menos visitadas.
+    auto roomForNode = [&]() {
+        if (capBytes == 0) {
+            return true;
+        }
+        if (liveBytes > pruneLimit) {
+            prune(pruneTarget);
+        }
+        if (freeSlots.empty() && nodes.size() == nodes.capacity()) {
+            const std::size_t fit = liveBytes < pruneTarget ? (pruneTarget - liveBytes) / slotBytes : 0;
+            const std::size_t extra = std::min(std::max<std::size_t>(nodes.capacity(), 1), fit);
+            if (extra > 0) {
+                liveBytes -= containerBytes();
+                nodes.reserve(nodes.capacity() + extra);
+                if (useTranspositions) {
+                    nodeKeys.reserve(nodes.capacity());
+                }
+                liveBytes += containerBytes();
+            } else {
+                const std::size_t listBytes = liveBytes - containerBytes();
+                prune(liveBytes - listBytes / 4);
+            }
+        }
+        return liveBytes <= pruneLimit && (!freeSlots.empty() || nodes.size() < nodes.capacity());
+    };
+    tetris_env::bitboard::Rows rows{};
+    TetrisEnv sim = env;
+    result.peakNodes = liveNodes;
+    result.peakBytes = liveBytes;
+
+    MctsSearchStats& stats = result.stats;
+    const bool timed = params_.telemetry;
+    std::chrono::steady_clock::time_point lapStart{};
+    // Fecha a fase atual somando o tempo desde a marca anterior.
+    auto lap = [&](double& phaseMs) {
+        if (timed) {
+            const auto now = std::chrono::steady_clock::now();
+            phaseMs += std::chrono::duration<double, std::milli>(now - lapStart).count();
+            lapStart = now;
+        }
+    };
 
-    GreedyAgent rolloutGreedyPolicy;
+    int completed = 0;
+    for (; completed < iterations; ++completed) {
+        if (stoppable && budget.stop->load(std::memory_order_relaxed)) {
+            break;
+        }
+        if (hasDeadline || params_.earlyStop) {
+            const auto now = std::chrono::steady_clock::now();
+            if (hasDeadline && now >= *budget.deadline) {
+                break;
+            }
 
-    for (int i = 0; i < iterations; ++i) {
-        TetrisEnv sim = env.clone();
+            if (params_.earlyStop && completed > 0 && completed % kEarlyStopCheckInterval == 0) {
+                double remaining = static_cast<double>(iterations - completed);
+                if (hasDeadline) {
+                    // Estima quantas iteracoes ainda cabem no deadline pela taxa observada ate aqui.
+                    const double elapsed = std::chrono::duration<double>(now - searchStart).count();
+                    const double left = std::chrono::duration<double>(*budget.deadline - now).count();
+                    if (elapsed > 0.0) {
+                        remaining = std::min(remaining, static_cast<double>(completed) * left / elapsed);
+                    }
+                }
+                if (rootDecided(nodes, static_cast<int>(std::ceil(remaining)))) {
+                    result.stoppedEarly = true;
+                    break;
+                }
+            }
+        }
+
+        // Sem folhas podaveis a arvore para de crescer e a iteracao so faz o rollout.
+        const bool canGrow = roomForNode();
+        result.peakBytes = std::max(result.peakBytes, liveBytes);
+
+        if (timed) {
+            lapStart = std::chrono::steady_clock::now();
+        }
+        // Copia para o mesmo objeto: reaproveita a memoria da fila entre iteracoes.
+        if (openLoop) {
+            // Pecas alem da fila visivel sorteadas de novo a cada iteracao, com o gerador leve do
+            // Bag: copiar e semear o mt19937 do jogo custava mais de 1 us por iteracao.
+            sim.resampleFrom(env, static_cast<std::uint32_t>(rng()));
+        } else {
+            sim = env;
+        }
         int nodeIndex = 0;
         double accumulatedReward = 0.0;
         int depth = 0;
+        int expandIndex = -1;
+        int consumedPieces = 0;
+        bool checkActions = false;
+        played.clear();
 
         // Selection
         while (true) {
             Node& node = nodes[nodeIndex];
+            expandIndex = -1;
 
             if (node.terminal || depth >= params_.maxDepth) {
                 break;
             }
 
-            if (!node.untriedActions.empty()) {
+            if (openLoop) {
+                if (sim.isGameOver()) {
+                    break;
+                }
+                checkActions = consumedPieces >= kKnownPieces || node.inherited;
+                if (checkActions) {
+                    rows = tetris_env::bitboard::rowsFromBoard(sim.getBoard());
+                }
+                if (node.untriedActions.empty() && node.children.empty()) {
+                    // No criado numa amostra que terminou o jogo: recebe as jogadas desta amostra.
+                    liveBytes -= nodeFootprint(node);
+                    node.untriedActions = sim.getValidActions();
+                    if (progressive) {
+                        orderByHeuristic(sim, node);
+                    }
+                    liveBytes += nodeFootprint(node);
+                    result.peakBytes = std::max(result.peakBytes, liveBytes);
+                }
+                if (canExpand(node)) {
+                    expandIndex = applicableUntried(node.untriedActions, rows, sim.game(), progressive, checkActions, rng);
+                    if (expandIndex >= 0) {
+                        break;
+                    }
+                }
+            } else if (canExpand(node)) {
                 break;
             }
 
             if (node.children.empty()) {
-                node.terminal = true;
+                if (!openLoop) {
+                    node.terminal = true;
+                }
                 break;
             }
 
-            int bestChild = node.children.front();
+            int bestChild = -1;
             double bestScore = -std::numeric_limits<double>::infinity();
             const double parentVisitsLog = std::log(std::max(1, node.visits));
+            const double parentVisitsSqrt = std::sqrt(static_cast<double>(std::max(1, node.visits)));
 
             for (int childIndex : node.children) {
                 const Node& child = nodes[static_cast<std::size_t>(childIndex)];
-                const double q = child.visits > 0 ? (child.totalValue / child.visits) : 0.0;
-                const double u = params_.exploration *
-                                 std::sqrt(parentVisitsLog / (1.0 + static_cast<double>(child.visits)));
+                if (checkActions && !actionApplicable(rows, sim.game(), child.actionFromParent)) {
+                    continue;
+                }
+                double q = child.visits > 0 ? (child.totalValue / child.visits) : 0.0;
+                if (rave && child.amafVisits > 0) {
+                    const double beta = std::sqrt(params_.raveK / (3.0 * child.visits + params_.raveK));
+                    q = (1.0 - beta) * q + beta * (child.amafValue / child.amafVisits);
+                }
+                const double u = puct
+                    ? params_.exploration * child.prior * parentVisitsSqrt / (1.0 + static_cast<double>(child.visits))
+                    : params_.exploration *
+                          std::sqrt(parentVisitsLog / (1.0 + static_cast<double>(child.visits)));
                 const double score = q + u;
 
                 if (score > bestScore) {
@@ -248,26 +974,23 @@ MctsRolloutAgent::SearchResult MctsRolloutAgent::runSearch(const TetrisEnv& env,
                     bestChild = childIndex;
                 }
             }
+            if (bestChild < 0) {
+                break; // nenhuma jogada da arvore cabe nesta amostra
+            }
 
             const Action& a = nodes[static_cast<std::size_t>(bestChild)].actionFromParent;
-            tetris_env::BoardFeatures beforeFeatures{};
-            tetris_env::BoardFeatures afterFeatures{};
-            const tetris_env::BoardFeatures* beforePtr = nullptr;
-            const tetris_env::BoardFeatures* afterPtr = nullptr;
-            if (params_.valueFunction == MctsValueFunction::GreedyHeuristic) {
-                beforeFeatures = tetris_env::computeBoardFeatures(sim);
-                beforePtr = &beforeFeatures;
-            }
-            const StepResult r = sim.step(a);
-            if (params_.valueFunction == MctsValueFunction::GreedyHeuristic) {
-                afterFeatures = tetris_env::computeBoardFeatures(sim);
-                afterPtr = &afterFeatures;
+            if (rave) {
+                played.push_back(nodes[static_cast<std::size_t>(bestChild)].placementKey);
             }
-            accumulatedReward += stepValue(r, beforePtr, afterPtr);
+            // Hold com o slot vazio puxa mais uma peca da fila.
+            consumedPieces += (a.useHold && !sim.game().hasHoldPiece()) ? 2 : 1;
+            const StepResult r = stepWithValue<Value>(sim, a, accumulatedReward);
             ++depth;
 
             if (r.done || sim.isGameOver()) {
-                nodes[static_cast<std::size_t>(bestChild)].terminal = true;
+                if (!openLoop) {
+                    nodes[static_cast<std::size_t>(bestChild)].terminal = true;
+                }
                 nodeIndex = bestChild;
                 break;
             }
@@ -275,92 +998,141 @@ MctsRolloutAgent::SearchResult MctsRolloutAgent::runSearch(const TetrisEnv& env,
             nodeIndex = bestChild;
         }
 
+        lap(stats.selectionMs);
+
         // Expansion
         Node& selectedNode = nodes[static_cast<std::size_t>(nodeIndex)];
-        if (!selectedNode.terminal && depth < params_.maxDepth && !selectedNode.untriedActions.empty()) {
-            std::uniform_int_distribution<std::size_t> dist(0, selectedNode.untriedActions.size() - 1);
-            const std::size_t actionIdx = dist(rng);
-            Action a = selectedNode.untriedActions[actionIdx];
-            selectedNode.untriedActions[actionIdx] = selectedNode.untriedActions.back();
-            selectedNode.untriedActions.pop_back();
-
-            tetris_env::BoardFeatures beforeFeatures{};
-            tetris_env::BoardFeatures afterFeatures{};
-            const tetris_env::BoardFeatures* beforePtr = nullptr;
-            const tetris_env::BoardFeatures* afterPtr = nullptr;
-            if (params_.valueFunction == MctsValueFunction::GreedyHeuristic) {
-                beforeFeatures = tetris_env::computeBoardFeatures(sim);
-                beforePtr = &beforeFeatures;
-            }
-            const StepResult r = sim.step(a);
-            if (params_.valueFunction == MctsValueFunction::GreedyHeuristic) {
-                afterFeatures = tetris_env::computeBoardFeatures(sim);
-                afterPtr = &afterFeatures;
+        const bool expandable = openLoop ? expandIndex >= 0 : !selectedNode.untriedActions.empty();
+        if (canGrow && !selectedNode.terminal && depth < params_.maxDepth && expandable) {
+            Action a{};
+            double prior = 0.0;
+            if (progressive) {
+                const std::size_t actionIdx = openLoop
+                    ? static_cast<std::size_t>(expandIndex)
+                    : selectedNode.untriedActions.size() - 1;
+                a = selectedNode.untriedActions[actionIdx];
+                prior = selectedNode.untriedPriors[actionIdx];
+                selectedNode.untriedActions.erase(selectedNode.untriedActions.begin() +
+                                                  static_cast<std::ptrdiff_t>(actionIdx));
+                selectedNode.untriedPriors.erase(selectedNode.untriedPriors.begin() +
+                                                 static_cast<std::ptrdiff_t>(actionIdx));
+            } else {
+                std::size_t actionIdx = 0;
+                if (openLoop) {
+                    actionIdx = static_cast<std::size_t>(expandIndex);
+                } else {
+                    std::uniform_int_distribution<std::size_t> dist(0, selectedNode.untriedActions.size() - 1);
+                    actionIdx = dist(rng);
+                }
+                a = selectedNode.untriedActions[actionIdx];
+                selectedNode.untriedActions[actionIdx] = selectedNode.untriedActions.back();
+                selectedNode.untriedActions.pop_back();
             }
 
-            accumulatedReward += stepValue(r, beforePtr, afterPtr);
+            const int key = placementKeyFor(sim, a);
+            if (rave) {
+                played.push_back(key);
+            }
+            const StepResult r = stepWithValue<Value>(sim, a, accumulatedReward);
             ++depth;
 
             Node child{};
             child.parent = nodeIndex;
             child.actionFromParent = a;
-            child.terminal = r.done || sim.isGameOver();
+            child.placementKey = key;
+            // Em malha aberta o fim de jogo e da amostra, nao do no.
+            child.terminal = !openLoop && (r.done || sim.isGameOver());
+            child.prior = prior;
 
-            if (!child.terminal) {
+            if (!child.terminal && !sim.isGameOver()) {
                 child.untriedActions = sim.getValidActions();
-                if (child.untriedActions.empty()) {
+                if (child.untriedActions.empty() && !openLoop) {
                     child.terminal = true;
+                } else if (progressive) {
+                    orderByHeuristic(sim, child);
                 }
             }
 
-            const int childIndex = static_cast<int>(nodes.size());
-            nodes.push_back(std::move(child));
-            if (useTranspositions) {
-                nodeKeys.push_back(makeKey(sim));
-                const auto it = table->find(nodeKeys.back());
-                if (it != table->end()) {
-                    nodes.back().visits = it->second.visits;
-                    nodes.back().totalValue = it->second.totalValue;
+            liveBytes += nodeFootprint(child);
+            int childIndex = 0;
+            if (!freeSlots.empty()) {
+                childIndex = freeSlots.back();
+                freeSlots.pop_back();
+                nodes[static_cast<std::size_t>(childIndex)] = std::move(child);
+                if (useTranspositions) {
+                    nodeKeys[static_cast<std::size_t>(childIndex)] = makeKey(sim);
                 }
+            } else {
+                // Sem teto os vetores dobram por conta propria; a capacidade nova entra na conta.
+                const std::size_t before = containerBytes();
+                childIndex = static_cast<int>(nodes.size());
+                nodes.push_back(std::move(child));
+                if (useTranspositions) {
+                    nodeKeys.push_back(makeKey(sim));
+                }
+                liveBytes += containerBytes() - before;
             }
-
-            nodes[static_cast<std::size_t>(nodeIndex)].children.push_back(childIndex);
+            if (useTranspositions &&
+                seedFromTransposition(table, tableLimit, nodeKeys[static_cast<std::size_t>(childIndex)],
+                                      nodes[static_cast<std::size_t>(childIndex)])) {
+                ++stats.ttHits;
+            }
+            ++stats.nodesAllocated;
+
+            Node& parent = nodes[static_cast<std::size_t>(nodeIndex)];
+            liveBytes -= nodeFootprint(parent);
+            parent.children.push_back(childIndex);
+            liveBytes += nodeFootprint(parent);
+            ++liveNodes;
+            result.peakNodes = std::max(result.peakNodes, liveNodes);
+            result.peakBytes = std::max(result.peakBytes, liveBytes);
             nodeIndex = childIndex;
         }
 
+        lap(stats.expansionMs);
+
         // Rollout
         const Node& rolloutNode = nodes[static_cast<std::size_t>(nodeIndex)];
-        if (!rolloutNode.terminal && depth < params_.maxDepth) {
-            while (!sim.isGameOver() && depth < params_.maxDepth) {
-                const auto actions = sim.getValidActions();
-                if (actions.empty()) {
+        const int treeDepth = depth;
+        stats.maxTreeDepth = std::max(stats.maxTreeDepth, treeDepth);
+        stats.treeDepthSum += treeDepth;
+        bool leafEvaluated = false;
+        if (!rolloutNode.terminal && depth < rolloutDepthLimit(depth) && batchRollouts) {
+            // As lanes ja somam o valor estatico dos seus estados finais.
+            const int steps = rolloutDepthLimit(depth) - depth;
+            constexpr bool heuristicValue = Value == MctsValueFunction::GreedyHeuristic;
+            if constexpr (Policy == MctsRolloutPolicy::Greedy) {
+                accumulatedReward += batch.runGreedy(sim, steps, heuristicValue, leafWeight, rng);
+            } else {
+                accumulatedReward += batch.runRandom(sim, steps, heuristicValue, leafWeight, rng);
+            }
+            leafEvaluated = true;
+        } else if (!rolloutNode.terminal && depth < rolloutDepthLimit(depth)) {
+            const int depthLimit = rolloutDepthLimit(depth);
+            while (!sim.isGameOver() && depth < depthLimit) {
+                bool done = false;
+                int placedKey = -1;
+                if (!rolloutStep<Policy, Value>(sim, rng, accumulatedReward, done, placedKey)) {
                     break;
                 }
-
-                Action a = rolloutAction(sim, actions, rng, rolloutGreedyPolicy);
-
-                tetris_env::BoardFeatures beforeFeatures{};
-                tetris_env::BoardFeatures afterFeatures{};
-                const tetris_env::BoardFeatures* beforePtr = nullptr;
-                const tetris_env::BoardFeatures* afterPtr = nullptr;
-                if (params_.valueFunction == MctsValueFunction::GreedyHeuristic) {
-                    beforeFeatures = tetris_env::computeBoardFeatures(sim);
-                    beforePtr = &beforeFeatures;
+                if (rave) {
+                    played.push_back(placedKey);
                 }
-                const StepResult r = sim.step(a);
-                if (params_.valueFunction == MctsValueFunction::GreedyHeuristic) {
-                    afterFeatures = tetris_env::computeBoardFeatures(sim);
-                    afterPtr = &afterFeatures;
-                }
-
-                accumulatedReward += stepValue(r, beforePtr, afterPtr);
                 ++depth;
-
-                if (r.done) {
+                if (done) {
                     break;
                 }
             }
         }
+        if (!leafEvaluated && leafWeight != 0.0 && !sim.isGameOver()) {
+            accumulatedReward += leafWeight * tetris_env::evaluateBoardState(tetris_env::computeBoardFeatures(sim));
+        }
+
+        lap(stats.rolloutMs);
+
+        if (rave) {
+            backpropagateAmaf(nodes, nodeIndex, treeDepth, played, accumulatedReward);
+        }
 
         // Backpropagation
         int current = nodeIndex;
@@ -377,18 +1149,27 @@ MctsRolloutAgent::SearchResult MctsRolloutAgent::runSearch(const TetrisEnv& env,
                     it->second.totalValue += accumulatedReward;
                 } else if (table->size() < tableLimit) {
                     table->emplace(key, TranspositionEntry{1, accumulatedReward});
+                    ++stats.ttInserts;
+                } else {
+                    ++stats.ttRejects;
                 }
             }
 
             current = n.parent;
         }
+        lap(stats.backpropMs);
     }
 
+    result.iterations = completed;
+    result.elapsedMs =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - searchStart).count();
+
     for (int childIndex : nodes.front().children) {
         const Node& child = nodes[static_cast<std::size_t>(childIndex)];
         for (std::size_t i = 0; i < rootActions.size(); ++i) {
             if (actionsEqual(rootActions[i], child.actionFromParent)) {
                 result.visits[i] += child.visits;
+                result.searchVisits[i] += child.visits - child.seedVisits;
                 result.totalValue[i] += child.totalValue;
                 break;
             }
@@ -399,7 +1180,12 @@ MctsRolloutAgent::SearchResult MctsRolloutAgent::runSearch(const TetrisEnv& env,
 }
 
 Action MctsRolloutAgent::chooseAction(const TetrisEnv& env) {
-    if (params_.iterations <= 0 || params_.maxDepth <= 0 || params_.exploration <= 0.0) {
+    lastMoveStats_ = MctsMoveStats{};
+    ++moveIndex_;
+    lastMoveStats_.moveIndex = moveIndex_;
+
+    const bool timeBudgeted = usesTimeBudget();
+    if ((params_.iterations <= 0 && !timeBudgeted) || params_.maxDepth <= 0 || params_.exploration <= 0.0) {
         return Action{};
     }
 
@@ -412,75 +1198,61 @@ Action MctsRolloutAgent::chooseAction(const TetrisEnv& env) {
         return Action{};
     }
 
-    const int totalIterations = params_.iterations;
-    const int maxThreads = std::max(1, params_.threads);
-    const int workerCount = std::max(1, std::min(totalIterations, maxThreads));
-    const int baseIterations = totalIterations / workerCount;
-    const int remainder = totalIterations % workerCount;
-
-    std::vector<SearchResult> partial(static_cast<std::size_t>(workerCount));
-
-    if (workerCount == 1) {
-        TranspositionTable* tablePtr = params_.useTranspositionTable ? &transpositionTable_ : nullptr;
-        partial.front() = runSearch(env, rootActions, totalIterations, rng_, tablePtr);
-    } else {
-        std::vector<std::thread> workers;
-        workers.reserve(static_cast<std::size_t>(workerCount));
-
-        std::vector<std::uint32_t> seeds(static_cast<std::size_t>(workerCount));
-        for (int i = 0; i < workerCount; ++i) {
-            seeds[static_cast<std::size_t>(i)] = rng_();
-        }
-
-        std::vector<TranspositionTable> localTables;
-        if (params_.useTranspositionTable) {
-            localTables.resize(static_cast<std::size_t>(workerCount));
-        }
+    const auto moveStart = std::chrono::steady_clock::now();
+    const MoveBudget moveBudget = planMoveBudget(env);
+    std::optional<std::chrono::steady_clock::time_point> deadline{};
+    if (timeBudgeted) {
+        deadline = moveStart + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                   std::chrono::duration<double, std::milli>(moveBudget.moveTimeMs));
+    }
 
-        for (int i = 0; i < workerCount; ++i) {
-            const int iterationsForThread = baseIterations + (i < remainder ? 1 : 0);
-            workers.emplace_back([&, i, iterationsForThread]() {
-                std::mt19937 localRng(seeds[static_cast<std::size_t>(i)]);
-                TranspositionTable* tablePtr = params_.useTranspositionTable
-                    ? &localTables[static_cast<std::size_t>(i)]
-                    : nullptr;
-                partial[static_cast<std::size_t>(i)] =
-                    runSearch(env, rootActions, iterationsForThread, localRng, tablePtr);
-            });
-        }
+    // Com deadline, todas as threads buscam ate o fim do orcamento de tempo.
+    const int totalIterations = timeBudgeted ? 0 : moveBudget.iterations;
+    const int maxThreads = std::max(1, params_.threads);
+    const int workerCount = timeBudgeted ? maxThreads : std::max(1, std::min(totalIterations, maxThreads));
 
-        for (auto& w : workers) {
-            if (w.joinable()) {
-                w.join();
-            }
-        }
-
-        if (params_.useTranspositionTable && ttMaxEntries_ > 0) {
-            for (const auto& table : localTables) {
-                for (const auto& kv : table) {
-                    auto it = transpositionTable_.find(kv.first);
-                    if (it != transpositionTable_.end()) {
-                        it->second.visits += kv.second.visits;
-                        it->second.totalValue += kv.second.totalValue;
-                    } else if (transpositionTable_.size() < ttMaxEntries_) {
-                        transpositionTable_.emplace(kv.first, kv.second);
-                    }
-                }
-            }
-        }
-    }
+    prepareTrees(env, rootActions, workerCount);
+    const std::vector<SearchResult> partial =
+        runWorkers(env, rootActions, workerCount, SearchBudget{totalIterations, deadline, nullptr});
 
     std::vector<int> totalVisits(rootActions.size(), 0);
+    std::vector<int> searchVisits(rootActions.size(), 0);
     std::vector<double> totalValues(rootActions.size(), 0.0);
     for (const auto& res : partial) {
         for (std::size_t i = 0; i < rootActions.size(); ++i) {
             totalVisits[i] += res.visits[i];
+            searchVisits[i] += res.searchVisits[i];
             totalValues[i] += res.totalValue[i];
         }
+        lastMoveStats_.iterations += res.iterations;
+        lastMoveStats_.stoppedEarly = lastMoveStats_.stoppedEarly || res.stoppedEarly;
+        lastMoveStats_.peakNodes += res.peakNodes;
+        lastMoveStats_.peakNodeBytes += res.peakBytes;
+        lastMoveStats_.prunedNodes += res.prunedNodes;
+
+        MctsSearchStats& search = lastMoveStats_.search;
+        search.maxTreeDepth = std::max(search.maxTreeDepth, res.stats.maxTreeDepth);
+        search.treeDepthSum += res.stats.treeDepthSum;
+        search.nodesAllocated += res.stats.nodesAllocated;
+        search.ttHits += res.stats.ttHits;
+        search.ttInserts += res.stats.ttInserts;
+        search.ttRejects += res.stats.ttRejects;
+        search.selectionMs += res.stats.selectionMs;
+        search.expansionMs += res.stats.expansionMs;
+        search.rolloutMs += res.stats.rolloutMs;
+        search.backpropMs += res.stats.backpropMs;
+
+        const bool first = lastMoveStats_.workers++ == 0;
+        lastMoveStats_.minWorkerIterations =
+            first ? res.iterations : std::min(lastMoveStats_.minWorkerIterations, res.iterations);
+        lastMoveStats_.maxWorkerIterations = std::max(lastMoveStats_.maxWorkerIterations, res.iterations);
+        lastMoveStats_.minWorkerMs = first ? res.elapsedMs : std::min(lastMoveStats_.minWorkerMs, res.elapsedMs);
+        lastMoveStats_.maxWorkerMs = std::max(lastMoveStats_.maxWorkerMs, res.elapsedMs);
     }
 
     Action bestAction = rootActions.front();
     double bestValue = -std::numeric_limits<double>::infinity();
+    int bestVisits = 0;
     bool foundVisitedChild = false;
 
     for (std::size_t i = 0; i < rootActions.size(); ++i) {
@@ -488,17 +1260,218 @@ Action MctsRolloutAgent::chooseAction(const TetrisEnv& env) {
             continue;
         }
 
+        // Com early stop o criterio de parada garante a acao mais visitada nesta busca, entao ela
+        // decide (desempate pela media); sem early stop mantem a maior media.
         const double meanValue = totalValues[i] / static_cast<double>(totalVisits[i]);
-        if (meanValue > bestValue) {
+        const bool better = params_.earlyStop
+            ? (searchVisits[i] > bestVisits || (searchVisits[i] == bestVisits && meanValue > bestValue))
+            : meanValue > bestValue;
+        if (better) {
             bestValue = meanValue;
+            bestVisits = searchVisits[i];
             bestAction = rootActions[i];
             foundVisitedChild = true;
         }
     }
 
+    lastMoveStats_.elapsedMs =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - moveStart).count();
+    settleMoveBudget();
+
     if (!foundVisitedChild) {
         bestAction = randomAction(rootActions, rng_);
     }
+    if (telemetryCallback_) {
+        telemetryCallback_(lastMoveStats_);
+    }
+    if (treeDump_) {
+        dumpTrees(env, bestAction);
+    }
+
+    if (retainsTrees()) {
+        TetrisEnv next = env.clone();
+        next.step(bestAction);
+        rememberTrees(next, bestAction);
+    } else {
+        trees_.clear();
+    }
 
     return bestAction;
 }
+
+void MctsRolloutAgent::ponder(const TetrisEnv& predicted, const std::atomic<bool>& stop) {
+    // Sem arvore guardada nem TT, nada do que fosse buscado aqui chegaria a proxima decisao.
+    if (!retainsTrees() && !params_.useTranspositionTable) {
+        return;
+    }
+    if (params_.maxDepth <= 0 || params_.exploration <= 0.0 || predicted.isGameOver()) {
+        return;
+    }
+    const auto rootActions = predicted.getValidActions();
+    if (rootActions.empty()) {
+        return;
+    }
+
+    const int workerCount = std::max(1, params_.threads);
+    prepareTrees(predicted, rootActions, workerCount);
+    runWorkers(predicted, rootActions, workerCount, SearchBudget{0, std::nullopt, &stop});
+    if (retainsTrees()) {
+        rememberTrees(predicted, std::nullopt);
+    }
+}
+
+void MctsRolloutAgent::dumpTrees(const TetrisEnv& env, const Action& chosen) const {
+    namespace td = tetris_env::treedump;
+    td::MoveRecord record;
+    record.episode = static_cast<std::uint32_t>(episodeIndex_);
+    record.move = static_cast<std::uint32_t>(moveIndex_);
+    record.chosenAction = td::packAction(chosen);
+    record.workers.resize(trees_.size());
+    for (std::size_t i = 0; i < trees_.size(); ++i) {
+        if (!trees_[i].empty()) {
+            appendDumpNode(trees_[i], 0, 0, params_.treeDumpBoards ? &env : nullptr, record.workers[i]);
+        }
+    }
+
+    // So a codificacao fica na thread da busca; a escrita e do Writer.
+    std::vector<unsigned char> bytes;
+    td::encodeMove(record, params_.treeDumpBoards, bytes);
+    treeDump_->enqueue(std::move(bytes));
+}
+
+void MctsRolloutAgent::appendDumpNode(const std::vector<Node>& nodes,
+                                      int index,
+                                      int depth,
+                                      const TetrisEnv* state,
+                                      std::vector<tetris_env::treedump::NodeRecord>& out) const {
+    namespace td = tetris_env::treedump;
+    const Node& node = nodes[static_cast<std::size_t>(index)];
+
+    std::vector<int> top;
+    if (depth < params_.treeDumpDepth) {
+        top = node.children;
+        const std::size_t keep = std::min<std::size_t>(top.size(), std::clamp(params_.treeDumpTopN, 1, 255));
+        std::partial_sort(top.begin(), top.begin() + static_cast<std::ptrdiff_t>(keep), top.end(), [&](int a, int b) {
+            return nodes[static_cast<std::size_t>(a)].visits > nodes[static_cast<std::size_t>(b)].visits;
+        });
+        top.resize(keep);
+    }
+
+    td::NodeRecord record;
+    record.action = index == 0 ? td::kNoAction : td::packAction(node.actionFromParent);
+    record.childCount = static_cast<std::uint8_t>(top.size());
+    record.visits = static_cast<std::uint32_t>(std::max(0, node.visits));
+    record.meanValue = node.visits > 0 ? static_cast<float>(node.totalValue / node.visits) : 0.0f;
+    if (state != nullptr) {
+        record.board = tetris_env::bitboard::rowsFromBoard(state->getBoard());
+    }
+    out.push_back(record);
+
+    for (int child : top) {
+        if (state != nullptr) {
+            // Tabuleiro reaplicando o caminho com a sequencia de pecas do ambiente da raiz.
+            TetrisEnv next = state->clone();
+            next.step(nodes[static_cast<std::size_t>(child)].actionFromParent);
+            appendDumpNode(nodes, child, depth + 1, &next, out);
+        } else {
+            appendDumpNode(nodes, child, depth + 1, nullptr, out);
+        }
+    }
+}
+
+bool MctsRolloutAgent::retainsTrees() const {
+    return params_.openLoop && (params_.reuseTree || params_.ponder);
+}
+
+void MctsRolloutAgent::prepareTrees(const TetrisEnv& env, const std::vector<Action>& rootActions, int workerCount) {
+    if (retainsTrees() && trees_.size() == static_cast<std::size_t>(workerCount) && reusableTree(env)) {
+        // Sem jogada registrada a arvore ja esta enraizada neste estado (veio do ponder).
+        if (reuseAction_.has_value()) {
+            for (auto& tree : trees_) {
+                rerootTree(tree, env, rootActions);
+            }
+        }
+    } else {
+        trees_.assign(static_cast<std::size_t>(workerCount), std::vector<Node>{});
+    }
+}
+
+void MctsRolloutAgent::rememberTrees(const TetrisEnv& root, const std::optional<Action>& played) {
+    reuseAction_ = played;
+    reuseTurn_ = root.getTurnNumber();
+    reuseBoard_ = root.getBoard();
+}
+
+std::vector<MctsRolloutAgent::SearchResult> MctsRolloutAgent::runWorkers(const TetrisEnv& env,
+                                                                         const std::vector<Action>& rootActions,
+                                                                         int workerCount,
+                                                                         const SearchBudget& budget) {
+    // budget.iterations e o total da jogada, repartido entre os workers.
+    const int baseIterations = budget.iterations / workerCount;
+    const int remainder = budget.iterations % workerCount;
+
+    std::vector<SearchResult> partial(static_cast<std::size_t>(workerCount));
+    const SearchFn search = selectSearch();
+
+    if (workerCount == 1) {
+        TranspositionTable* tablePtr = params_.useTranspositionTable ? &transpositionTable_ : nullptr;
+        partial.front() = (this->*search)(env, rootActions, budget, rng_, tablePtr, trees_.front());
+        return partial;
+    }
+
+    std::vector<std::thread> workers;
+    workers.reserve(static_cast<std::size_t>(workerCount));
+
+    std::vector<std::uint32_t> seeds(static_cast<std::size_t>(workerCount));
+    for (int i = 0; i < workerCount; ++i) {
+        seeds[static_cast<std::size_t>(i)] = workerSeed(i);
+    }
+
+    std::vector<TranspositionTable> localTables;
+    if (params_.useTranspositionTable) {
+        localTables.resize(static_cast<std::size_t>(workerCount));
+    }
+
+    for (int i = 0; i < workerCount; ++i) {
+        SearchBudget workerBudget = budget;
+        workerBudget.iterations = baseIterations + (i < remainder ? 1 : 0);
+        workers.emplace_back([&, i, workerBudget]() {
+            std::mt19937 localRng(seeds[static_cast<std::size_t>(i)]);
+            TranspositionTable* tablePtr = params_.useTranspositionTable
+                ? &localTables[static_cast<std::size_t>(i)]
+                : nullptr;
+            partial[static_cast<std::size_t>(i)] = (this->*search)(env,
+                                                                   rootActions,
+                                                                   workerBudget,
+                                                                   localRng,
+                                                                   tablePtr,
+                                                                   trees_[static_cast<std::size_t>(i)]);
+        });
+    }
+
+    for (auto& w : workers) {
+        if (w.joinable()) {
+            w.join();
+        }
+    }
+
+    if (params_.useTranspositionTable && ttMaxEntries_ > 0) {
+        // As tabelas locais so tem o que cada worker somou nesta jogada.
+        for (const auto& table : localTables) {
+            for (const auto& kv : table) {
+                auto it = transpositionTable_.find(kv.first);
+                if (it != transpositionTable_.end()) {
+                    it->second.visits += kv.second.visits;
+                    it->second.totalValue += kv.second.totalValue;
+                } else if (transpositionTable_.size() < ttMaxEntries_) {
+                    TranspositionEntry entry = storedEntry(kv.first).value_or(TranspositionEntry{});
+                    entry.visits += kv.second.visits;
+                    entry.totalValue += kv.second.totalValue;
+                    transpositionTable_.emplace(kv.first, entry);
+                }
+            }
+        }
+    }
+
+    return partial;
+}
@@ -0,0 +1,33 @@
+#include "tetris_env/MoveLatency.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+namespace tetris {
+namespace {
+
+double nearestRank(const std::vector<double>& sorted, double percentile) {
+    const double rank = std::ceil(percentile / 100.0 * static_cast<double>(sorted.size()));
+    const std::size_t index = static_cast<std::size_t>(std::max(1.0, rank)) - 1;
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+} // namespace
+
+MoveLatencySummary summarizeMoveLatencies(std::vector<double> samplesMs) {
+    MoveLatencySummary summary{};
+    if (samplesMs.empty()) {
+        return summary;
+    }
+
+    std::sort(samplesMs.begin(), samplesMs.end());
+    summary.moves = static_cast<int>(samplesMs.size());
+    summary.p50Ms = nearestRank(samplesMs, 50.0);
+    summary.p90Ms = nearestRank(samplesMs, 90.0);
+    summary.p99Ms = nearestRank(samplesMs, 99.0);
+    summary.maxMs = samplesMs.back();
+    return summary;
+}
+
+} // namespace tetris
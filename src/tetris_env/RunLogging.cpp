@@ -1,15 +1,63 @@
 #include "tetris_env/RunLogging.hpp"
 
+#include <charconv>
 #include <chrono>
 #include <ctime>
-#include <filesystem>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
 
 namespace tetris {
 
+namespace {
+
+// Appends numbers with std::to_chars: no locale, no stream state, no allocation per field.
+class LineBuilder {
+public:
+    explicit LineBuilder(std::string& out) : out_(out) {}
+
+    LineBuilder& text(std::string_view value) {
+        out_.append(value);
+        return *this;
+    }
+
+    template <typename T, std::enable_if_t<std::is_integral_v<T>, int> = 0>
+    LineBuilder& number(T value) {
+        char buffer[32];
+        const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        out_.append(buffer, result.ptr);
+        return *this;
+    }
+
+    // Fixed notation, like std::fixed << std::setprecision(precision).
+    LineBuilder& fixed(double value, int precision) {
+        char buffer[64];
+        const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::fixed, precision);
+        if (result.ec == std::errc{}) {
+            out_.append(buffer, result.ptr);
+        } else {
+            std::ostringstream oss;
+            oss << std::fixed << std::setprecision(precision) << value;
+            out_.append(oss.str());
+        }
+        return *this;
+    }
+
+private:
+    std::string& out_;
+};
+
+} // namespace
+
+const char* const kEpisodeCsvHeader =
+    "run_id,episode_index,agent_name,mode_name,score,total_lines,total_turns,holds_used,elapsed_seconds,end_reason,agent_config,"
+    "move_latency_p50_ms,move_latency_p90_ms,move_latency_p99_ms,move_latency_max_ms,"
+    "search_iterations,search_seconds,tree_peak_nodes,tree_peak_mb,tree_pruned_nodes\n";
+
 std::string makeRunIdTimestamp() {
     const auto now = std::chrono::system_clock::now();
     std::time_t t = std::chrono::system_clock::to_time_t(now);
@@ -24,16 +72,150 @@ std::string makeRunIdTimestamp() {
     return oss.str();
 }
 
+std::filesystem::path runFilePath(const std::string& runId,
+                                  const std::string& agentDir,
+                                  const std::string& filenameSuffix,
+                                  const std::string& extension) {
+    return std::filesystem::path("agents") / agentDir / ("run_" + runId + filenameSuffix + extension);
+}
+
+void formatEpisodeCsvRow(const EpisodeReport& rep, std::string& out) {
+    LineBuilder line(out);
+    line.text(rep.runId).text(",")
+        .number(rep.episodeIndex).text(",")
+        .text(rep.agentName).text(",")
+        .text(rep.modeName).text(",")
+        .number(rep.score).text(",")
+        .number(rep.totalLines).text(",")
+        .number(rep.totalTurns).text(",")
+        .number(rep.holdsUsed).text(",")
+        .fixed(rep.elapsedSeconds, 2).text(",")
+        .text(rep.endReason).text(",")
+        .text(rep.agentConfig).text(",")
+        .fixed(rep.moveLatencyP50Ms, 3).text(",")
+        .fixed(rep.moveLatencyP90Ms, 3).text(",")
+        .fixed(rep.moveLatencyP99Ms, 3).text(",")
+        .fixed(rep.moveLatencyMaxMs, 3).text(",")
+        .number(rep.searchIterations).text(",")
+        .fixed(rep.searchSeconds, 3).text(",")
+        .number(rep.treePeakNodes).text(",")
+        .fixed(rep.treePeakMb, 3).text(",")
+        .number(rep.treePrunedNodes)
+        .text("\n");
+}
+
+bool parseEpisodeCsvRow(const std::string& line, EpisodeReport& rep) {
+    constexpr std::size_t kFields = 20;
+    std::vector<std::string> fields;
+    std::size_t start = 0;
+    while (fields.size() < kFields) {
+        const std::size_t comma = line.find(',', start);
+        fields.push_back(line.substr(start, comma == std::string::npos ? std::string::npos : comma - start));
+        if (comma == std::string::npos) {
+            break;
+        }
+        start = comma + 1;
+    }
+    if (fields.size() != kFields || line.find(',', start) != std::string::npos) {
+        return false;
+    }
+
+    try {
+        std::size_t used = 0;
+        auto toInt = [&used](const std::string& text) {
+            const int value = std::stoi(text, &used);
+            if (used != text.size()) {
+                throw std::invalid_argument(text);
+            }
+            return value;
+        };
+        auto toLong = [&used](const std::string& text) {
+            const long long value = std::stoll(text, &used);
+            if (used != text.size()) {
+                throw std::invalid_argument(text);
+            }
+            return value;
+        };
+        auto toFloat = [&used](const std::string& text) {
+            const float value = std::stof(text, &used);
+            if (used != text.size()) {
+                throw std::invalid_argument(text);
+            }
+            return value;
+        };
+        EpisodeReport parsed{};
+        parsed.runId = fields[0];
+        parsed.episodeIndex = toInt(fields[1]);
+        parsed.agentName = fields[2];
+        parsed.modeName = fields[3];
+        parsed.score = toInt(fields[4]);
+        parsed.totalLines = toInt(fields[5]);
+        parsed.totalTurns = toInt(fields[6]);
+        parsed.holdsUsed = toInt(fields[7]);
+        parsed.elapsedSeconds = toFloat(fields[8]);
+        parsed.endReason = fields[9];
+        parsed.agentConfig = fields[10];
+        parsed.moveLatencyP50Ms = toFloat(fields[11]);
+        parsed.moveLatencyP90Ms = toFloat(fields[12]);
+        parsed.moveLatencyP99Ms = toFloat(fields[13]);
+        parsed.moveLatencyMaxMs = toFloat(fields[14]);
+        parsed.searchIterations = toLong(fields[15]);
+        parsed.searchSeconds = toFloat(fields[16]);
+        parsed.treePeakNodes = toLong(fields[17]);
+        parsed.treePeakMb = toFloat(fields[18]);
+        parsed.treePrunedNodes = toLong(fields[19]);
+        rep = std::move(parsed);
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+void formatMoveTelemetryJsonl(const std::string& runId,
+                              int episodeIndex,
+                              const std::vector<MctsMoveStats>& moves,
+                              std::string& out) {
+    LineBuilder line(out);
+    for (const MctsMoveStats& m : moves) {
+        const MctsSearchStats& s = m.search;
+        const double iterationsPerSecond = m.elapsedMs > 0.0 ? m.iterations * 1000.0 / m.elapsedMs : 0.0;
+        const double meanDepth = m.iterations > 0 ? static_cast<double>(s.treeDepthSum) / m.iterations : 0.0;
+        line.text("{\"run_id\":\"").text(runId).text("\"")
+            .text(",\"episode\":").number(episodeIndex)
+            .text(",\"move\":").number(m.moveIndex)
+            .text(",\"iterations\":").number(m.iterations)
+            .text(",\"elapsed_ms\":").fixed(m.elapsedMs, 3)
+            .text(",\"iter_per_s\":").fixed(iterationsPerSecond, 3)
+            .text(",\"stopped_early\":").text(m.stoppedEarly ? "true" : "false")
+            .text(",\"workers\":").number(m.workers)
+            .text(",\"worker_iterations_min\":").number(m.minWorkerIterations)
+            .text(",\"worker_iterations_max\":").number(m.maxWorkerIterations)
+            .text(",\"worker_ms_min\":").fixed(m.minWorkerMs, 3)
+            .text(",\"worker_ms_max\":").fixed(m.maxWorkerMs, 3)
+            .text(",\"max_depth\":").number(s.maxTreeDepth)
+            .text(",\"mean_depth\":").fixed(meanDepth, 3)
+            .text(",\"nodes_allocated\":").number(s.nodesAllocated)
+            .text(",\"peak_nodes\":").number(m.peakNodes)
+            .text(",\"pruned_nodes\":").number(m.prunedNodes)
+            .text(",\"tt_hits\":").number(s.ttHits)
+            .text(",\"tt_inserts\":").number(s.ttInserts)
+            .text(",\"tt_rejects\":").number(s.ttRejects)
+            .text(",\"selection_ms\":").fixed(s.selectionMs, 3)
+            .text(",\"expansion_ms\":").fixed(s.expansionMs, 3)
+            .text(",\"rollout_ms\":").fixed(s.rolloutMs, 3)
+            .text(",\"backprop_ms\":").fixed(s.backpropMs, 3)
+            .text(",\"budget_scale\":").fixed(m.budgetScale, 3)
+            .text("}\n");
+    }
+}
+
 void appendEpisodeReportToRunFile(const EpisodeReport& rep,
                                   const std::string& agentDir,
                                   const std::string& filenameSuffix) {
     namespace fs = std::filesystem;
 
-    fs::path dir = fs::path("agents") / agentDir;
-    fs::create_directories(dir);
-
-    const std::string filename = "run_" + rep.runId + filenameSuffix + ".csv";
-    fs::path filepath = dir / filename;
+    const fs::path filepath = runFilePath(rep.runId, agentDir, filenameSuffix, ".csv");
+    fs::create_directories(filepath.parent_path());
 
     const bool isNewFile = !fs::exists(filepath);
 
@@ -43,22 +225,34 @@ void appendEpisodeReportToRunFile(const EpisodeReport& rep,
         return;
     }
 
-    if (isNewFile) {
-        file << "run_id,episode_index,agent_name,mode_name,score,total_lines,total_turns,holds_used,elapsed_seconds,end_reason,agent_config\n";
+    std::string text = isNewFile ? kEpisodeCsvHeader : "";
+    formatEpisodeCsvRow(rep, text);
+    file << text;
+}
+
+void appendMoveTelemetryToRunFile(const std::string& runId,
+                                  int episodeIndex,
+                                  const std::vector<MctsMoveStats>& moves,
+                                  const std::string& agentDir,
+                                  const std::string& filenameSuffix) {
+    namespace fs = std::filesystem;
+
+    if (moves.empty()) {
+        return;
+    }
+
+    const fs::path filepath = runFilePath(runId, agentDir, filenameSuffix, "_telemetry.jsonl");
+    fs::create_directories(filepath.parent_path());
+
+    std::ofstream file(filepath, std::ios::app);
+    if (!file.is_open()) {
+        std::cerr << "Erro ao abrir arquivo de telemetria: " << filepath << '\n';
+        return;
     }
 
-    file << rep.runId << ','
-         << rep.episodeIndex << ','
-         << rep.agentName << ','
-         << rep.modeName << ','
-         << rep.score << ','
-         << rep.totalLines << ','
-         << rep.totalTurns << ','
-         << rep.holdsUsed << ','
-         << std::fixed << std::setprecision(2) << rep.elapsedSeconds << ','
-         << rep.endReason << ','
-         << rep.agentConfig
-         << '\n';
+    std::string text;
+    formatMoveTelemetryJsonl(runId, episodeIndex, moves, text);
+    file << text;
 }
 
 } // namespace tetris
@@ -0,0 +1,163 @@
+#include "tetris_env/RunResume.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <system_error>
+
+#include "tetris_env/EpisodeTrace.hpp"
+#include "tetris_env/RunLogging.hpp"
+
+namespace tetris {
+
+bool rewriteFile(const std::filesystem::path& path, std::string_view content) {
+    const std::filesystem::path tmpPath = std::filesystem::path(path) += ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        out.write(content.data(), static_cast<std::streamsize>(content.size()));
+        if (!out) {
+            std::cerr << "Erro ao regravar " << tmpPath << '\n';
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) {
+        std::cerr << "Erro ao substituir " << path << ": " << ec.message() << '\n';
+        return false;
+    }
+    return true;
+}
+
+bool resumeTelemetry(const std::filesystem::path& path, const std::vector<bool>& done) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+        return true;
+    }
+    constexpr std::string_view kEpisodeField = "\"episode\":";
+    std::string kept;
+    std::string line;
+    int dropped = 0;
+    while (std::getline(in, line)) {
+        const std::size_t pos = line.find(kEpisodeField);
+        int episode = 0;
+        if (pos != std::string::npos) {
+            episode = std::atoi(line.c_str() + pos + kEpisodeField.size());
+        }
+        // A line cut by the interruption has no closing brace.
+        if (episode < 1 || episode > static_cast<int>(done.size()) || !done[static_cast<std::size_t>(episode - 1)] ||
+            line.empty() || line.back() != '}') {
+            ++dropped;
+            continue;
+        }
+        kept += line;
+        kept += '\n';
+    }
+    in.close();
+    if (dropped > 0) {
+        std::cout << "Retomada: " << dropped << " linha(s) de episodios nao concluidos descartada(s) de " << path
+                  << '\n';
+    }
+    return dropped == 0 || rewriteFile(path, kept);
+}
+
+bool resumeTrace(const std::filesystem::path& path, const std::vector<bool>& done) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return true;
+    }
+    std::ostringstream raw;
+    raw << file.rdbuf();
+    file.close();
+    const std::string bytes = raw.str();
+
+    std::istringstream in(bytes);
+    std::uint32_t flags = 0;
+    if (!tetris_env::trace::readHeader(in, flags)) {
+        std::cerr << "Aviso: " << path << " nao e um trace valido; mantido como esta\n";
+        return true;
+    }
+    const bool boardHash = (flags & tetris_env::trace::kFlagBoardHash) != 0;
+    std::string kept = bytes.substr(0, tetris_env::trace::kHeaderSize);
+    std::vector<bool> seen(done.size(), false);
+    tetris_env::trace::EpisodeRecord record;
+    int dropped = 0;
+    std::streamoff start = in.tellg();
+    while (in.peek() != std::istringstream::traits_type::eof()) {
+        if (!tetris_env::trace::readEpisode(in, boardHash, record)) {
+            ++dropped;
+            break;
+        }
+        const std::streamoff end = in.tellg();
+        const std::size_t index = static_cast<std::size_t>(record.episode) - 1;
+        if (record.episode >= 1 && index < done.size() && done[index] && !seen[index]) {
+            seen[index] = true;
+            kept.append(bytes, static_cast<std::size_t>(start), static_cast<std::size_t>(end - start));
+        } else {
+            ++dropped;
+        }
+        start = end;
+    }
+    if (dropped > 0) {
+        std::cout << "Retomada: " << dropped << " episodio(s) nao concluido(s) ou truncado(s) descartado(s) de "
+                  << path << '\n';
+    }
+    return dropped == 0 || rewriteFile(path, kept);
+}
+
+bool resumeRunFiles(const std::filesystem::path& csvPath,
+                    const std::filesystem::path& telemetryPath,
+                    const std::filesystem::path& tracePath,
+                    int episodes,
+                    ResumedRunFiles& out) {
+    out = ResumedRunFiles{};
+    out.reports.resize(static_cast<std::size_t>(episodes));
+    std::vector<bool> done(static_cast<std::size_t>(episodes), false);
+
+    if (std::filesystem::exists(csvPath)) {
+        std::ifstream in(csvPath);
+        if (!in.is_open()) {
+            std::cerr << "Erro: nao foi possivel abrir " << csvPath << " para retomar\n";
+            return false;
+        }
+        std::string kept = kEpisodeCsvHeader;
+        std::string line;
+        std::getline(in, line); // header
+        while (std::getline(in, line)) {
+            EpisodeReport rep{};
+            if (!parseEpisodeCsvRow(line, rep) || rep.episodeIndex < 1 || rep.episodeIndex > episodes ||
+                done[static_cast<std::size_t>(rep.episodeIndex - 1)]) {
+                ++out.droppedRows;
+                continue;
+            }
+            done[static_cast<std::size_t>(rep.episodeIndex - 1)] = true;
+            out.reports[static_cast<std::size_t>(rep.episodeIndex - 1)] = rep;
+            kept += line;
+            kept += '\n';
+        }
+        in.close();
+        if (!rewriteFile(csvPath, kept)) {
+            return false;
+        }
+        if (out.droppedRows > 0) {
+            std::cout << "Aviso: " << out.droppedRows << " linha(s) invalida(s) ou repetida(s) descartada(s) de "
+                      << csvPath << '\n';
+        }
+    }
+
+    // Telemetry and trace keep only the episodes kept in the CSV.
+    if (!resumeTelemetry(telemetryPath, done) || !resumeTrace(tracePath, done)) {
+        return false;
+    }
+    for (int episode = 1; episode <= episodes; ++episode) {
+        if (!done[static_cast<std::size_t>(episode - 1)]) {
+            out.missingEpisodes.push_back(episode);
+        }
+    }
+    return true;
+}
+
+} // namespace tetris
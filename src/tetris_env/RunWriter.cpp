@@ -0,0 +1,358 @@
+#include "tetris_env/RunWriter.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <system_error>
+
+#include "tetris_env/EpisodeTrace.hpp"
+#include "tetris_env/RunLogging.hpp"
+
+namespace tetris {
+
+namespace {
+
+constexpr std::array<char, 8> kColumnarMagic{'T', 'E', 'T', 'R', 'C', 'O', 'L', '1'};
+constexpr std::uint32_t kColumnarVersion = 1;
+constexpr std::size_t kColumnarHeaderSize = 64;
+constexpr std::size_t kColumnarDirectoryEntrySize = 56;
+constexpr std::size_t kColumnNameSize = 32;
+constexpr std::uint32_t kColumnInt64 = 0;
+constexpr std::uint32_t kColumnFloat64 = 1;
+constexpr std::uint32_t kColumnText = 2;
+constexpr std::uint32_t kEndReasonWidth = 16;
+
+template <typename T>
+void put(std::vector<unsigned char>& out, T value) {
+    const std::size_t offset = out.size();
+    out.resize(offset + sizeof(T));
+    std::memcpy(out.data() + offset, &value, sizeof(T));
+}
+
+void padTo(std::vector<unsigned char>& out, std::size_t size) {
+    out.resize(std::max(out.size(), size), 0);
+}
+
+std::size_t alignUp(std::size_t value) {
+    return (value + 7) & ~static_cast<std::size_t>(7);
+}
+
+struct ColumnData {
+    const char* name;
+    std::uint32_t type;
+    std::uint32_t width;
+    std::vector<unsigned char> bytes;
+};
+
+} // namespace
+
+struct RunWriter::Item {
+    enum class Kind { EpisodeRow, Telemetry, Trace, CloseRun };
+
+    Kind kind = Kind::EpisodeRow;
+    EpisodeReport report{};
+    std::string runId;
+    std::string agentDir;
+    std::string filenameSuffix;
+    int episodeIndex = 0;
+    std::vector<MctsMoveStats> moves;
+    std::vector<EpisodeReport> rows;
+    std::vector<unsigned char> bytes;
+    std::uint32_t flags = 0;
+    Item* next = nullptr;
+};
+
+RunWriter::RunWriter(bool columnar) : columnar_(columnar) {
+    thread_ = std::thread([this]() { run(); });
+}
+
+RunWriter::~RunWriter() {
+    stop_.store(true, std::memory_order_release);
+    signal_.fetch_add(1, std::memory_order_release);
+    signal_.notify_one();
+    thread_.join();
+}
+
+void RunWriter::appendEpisodeReport(const EpisodeReport& rep,
+                                    const std::string& agentDir,
+                                    const std::string& filenameSuffix) {
+    auto* item = new Item();
+    item->kind = Item::Kind::EpisodeRow;
+    item->report = rep;
+    item->runId = rep.runId;
+    item->agentDir = agentDir;
+    item->filenameSuffix = filenameSuffix;
+    push(item);
+}
+
+void RunWriter::appendMoveTelemetry(const std::string& runId,
+                                    int episodeIndex,
+                                    std::vector<MctsMoveStats> moves,
+                                    const std::string& agentDir,
+                                    const std::string& filenameSuffix) {
+    if (moves.empty()) {
+        return;
+    }
+    auto* item = new Item();
+    item->kind = Item::Kind::Telemetry;
+    item->runId = runId;
+    item->episodeIndex = episodeIndex;
+    item->moves = std::move(moves);
+    item->agentDir = agentDir;
+    item->filenameSuffix = filenameSuffix;
+    push(item);
+}
+
+void RunWriter::appendEpisodeTrace(const std::string& runId,
+                                   std::vector<unsigned char> bytes,
+                                   std::uint32_t flags,
+                                   const std::string& agentDir,
+                                   const std::string& filenameSuffix) {
+    auto* item = new Item();
+    item->kind = Item::Kind::Trace;
+    item->runId = runId;
+    item->bytes = std::move(bytes);
+    item->flags = flags;
+    item->agentDir = agentDir;
+    item->filenameSuffix = filenameSuffix;
+    push(item);
+}
+
+void RunWriter::closeRun(const std::string& runId,
+                         const std::string& agentDir,
+                         const std::string& filenameSuffix,
+                         std::vector<EpisodeReport> rows) {
+    auto* item = new Item();
+    item->kind = Item::Kind::CloseRun;
+    item->rows = std::move(rows);
+    item->runId = runId;
+    item->agentDir = agentDir;
+    item->filenameSuffix = filenameSuffix;
+    push(item);
+}
+
+void RunWriter::push(Item* item) {
+    Item* head = head_.load(std::memory_order_relaxed);
+    do {
+        item->next = head;
+    } while (!head_.compare_exchange_weak(head, item, std::memory_order_release, std::memory_order_relaxed));
+    signal_.fetch_add(1, std::memory_order_release);
+    signal_.notify_one();
+}
+
+void RunWriter::run() {
+    while (true) {
+        const std::uint32_t seen = signal_.load(std::memory_order_acquire);
+        Item* batch = head_.exchange(nullptr, std::memory_order_acquire);
+        if (batch == nullptr) {
+            if (stop_.load(std::memory_order_acquire)) {
+                // Anything pushed before the stop request is visible by now.
+                if (head_.load(std::memory_order_acquire) == nullptr) {
+                    break;
+                }
+                continue;
+            }
+            signal_.wait(seen, std::memory_order_acquire);
+            continue;
+        }
+
+        // The stack holds the newest item first; reverse it to keep push order.
+        Item* ordered = nullptr;
+        while (batch != nullptr) {
+            Item* next = batch->next;
+            batch->next = ordered;
+            ordered = batch;
+            batch = next;
+        }
+        while (ordered != nullptr) {
+            Item* next = ordered->next;
+            process(*ordered);
+            delete ordered;
+            ordered = next;
+        }
+        for (std::ofstream* file : dirty_) {
+            file->flush();
+        }
+        dirty_.clear();
+    }
+
+    files_.clear();
+}
+
+void RunWriter::process(Item& item) {
+    std::string text;
+    switch (item.kind) {
+    case Item::Kind::EpisodeRow: {
+        const auto path = runFilePath(item.runId, item.agentDir, item.filenameSuffix, ".csv");
+        if (std::ofstream* file = fileFor(path, kEpisodeCsvHeader)) {
+            formatEpisodeCsvRow(item.report, text);
+            file->write(text.data(), static_cast<std::streamsize>(text.size()));
+        }
+        break;
+    }
+    case Item::Kind::Telemetry: {
+        const auto path = runFilePath(item.runId, item.agentDir, item.filenameSuffix, "_telemetry.jsonl");
+        if (std::ofstream* file = fileFor(path, {})) {
+            formatMoveTelemetryJsonl(item.runId, item.episodeIndex, item.moves, text);
+            file->write(text.data(), static_cast<std::streamsize>(text.size()));
+        }
+        break;
+    }
+    case Item::Kind::Trace: {
+        const auto path = runFilePath(item.runId, item.agentDir, item.filenameSuffix, ".ttrace");
+        std::vector<unsigned char> header;
+        tetris_env::trace::encodeHeader(item.flags, header);
+        if (std::ofstream* file =
+                fileFor(path, std::string_view(reinterpret_cast<const char*>(header.data()), header.size()))) {
+            file->write(reinterpret_cast<const char*>(item.bytes.data()), static_cast<std::streamsize>(item.bytes.size()));
+        }
+        break;
+    }
+    case Item::Kind::CloseRun: {
+        const auto csvPath = runFilePath(item.runId, item.agentDir, item.filenameSuffix, ".csv");
+        const auto telemetryPath = runFilePath(item.runId, item.agentDir, item.filenameSuffix, "_telemetry.jsonl");
+        const auto tracePath = runFilePath(item.runId, item.agentDir, item.filenameSuffix, ".ttrace");
+        for (const auto& path : {csvPath, telemetryPath, tracePath}) {
+            auto it = files_.find(path);
+            if (it != files_.end()) {
+                dirty_.erase(std::remove(dirty_.begin(), dirty_.end(), &it->second), dirty_.end());
+                files_.erase(it);
+            }
+        }
+        if (columnar_) {
+            writeColumnar(csvPath, item.rows);
+        }
+        break;
+    }
+    }
+}
+
+std::ofstream* RunWriter::fileFor(const std::filesystem::path& path, std::string_view headerIfNew) {
+    auto it = files_.find(path);
+    if (it == files_.end()) {
+        std::error_code ec;
+        std::filesystem::create_directories(path.parent_path(), ec);
+        const bool isNewFile = !std::filesystem::exists(path, ec);
+        std::ofstream file(path, std::ios::app | std::ios::binary);
+        if (!file.is_open()) {
+            std::cerr << "Erro ao abrir arquivo de log: " << path << '\n';
+            return nullptr;
+        }
+        if (isNewFile && !headerIfNew.empty()) {
+            file.write(headerIfNew.data(), static_cast<std::streamsize>(headerIfNew.size()));
+        }
+        it = files_.emplace(path, std::move(file)).first;
+    }
+    std::ofstream* file = &it->second;
+    if (std::find(dirty_.begin(), dirty_.end(), file) == dirty_.end()) {
+        dirty_.push_back(file);
+    }
+    return file;
+}
+
+void RunWriter::writeColumnar(const std::filesystem::path& csvPath, const std::vector<EpisodeReport>& rows) {
+    if (rows.empty()) {
+        return;
+    }
+
+    std::vector<ColumnData> columns;
+    auto addInt = [&](const char* name, const std::function<long long(const EpisodeReport&)>& get) {
+        ColumnData column{name, kColumnInt64, 8, {}};
+        for (const auto& rep : rows) {
+            put(column.bytes, static_cast<std::int64_t>(get(rep)));
+        }
+        columns.push_back(std::move(column));
+    };
+    auto addFloat = [&](const char* name, const std::function<double(const EpisodeReport&)>& get) {
+        ColumnData column{name, kColumnFloat64, 8, {}};
+        for (const auto& rep : rows) {
+            put(column.bytes, get(rep));
+        }
+        columns.push_back(std::move(column));
+    };
+
+    addInt("episode_index", [](const EpisodeReport& r) { return r.episodeIndex; });
+    addInt("score", [](const EpisodeReport& r) { return r.score; });
+    addInt("total_lines", [](const EpisodeReport& r) { return r.totalLines; });
+    addInt("total_turns", [](const EpisodeReport& r) { return r.totalTurns; });
+    addInt("holds_used", [](const EpisodeReport& r) { return r.holdsUsed; });
+    addFloat("elapsed_seconds", [](const EpisodeReport& r) { return r.elapsedSeconds; });
+    {
+        ColumnData column{"end_reason", kColumnText, kEndReasonWidth, {}};
+        for (const auto& rep : rows) {
+            const std::size_t offset = column.bytes.size();
+            column.bytes.resize(offset + kEndReasonWidth, 0);
+            std::memcpy(column.bytes.data() + offset, rep.endReason.data(),
+                        std::min<std::size_t>(rep.endReason.size(), kEndReasonWidth));
+        }
+        columns.push_back(std::move(column));
+    }
+    addFloat("move_latency_p50_ms", [](const EpisodeReport& r) { return r.moveLatencyP50Ms; });
+    addFloat("move_latency_p90_ms", [](const EpisodeReport& r) { return r.moveLatencyP90Ms; });
+    addFloat("move_latency_p99_ms", [](const EpisodeReport& r) { return r.moveLatencyP99Ms; });
+    addFloat("move_latency_max_ms", [](const EpisodeReport& r) { return r.moveLatencyMaxMs; });
+    addInt("search_iterations", [](const EpisodeReport& r) { return r.searchIterations; });
+    addFloat("search_seconds", [](const EpisodeReport& r) { return r.searchSeconds; });
+    addInt("tree_peak_nodes", [](const EpisodeReport& r) { return r.treePeakNodes; });
+    addFloat("tree_peak_mb", [](const EpisodeReport& r) { return r.treePeakMb; });
+    addInt("tree_pruned_nodes", [](const EpisodeReport& r) { return r.treePrunedNodes; });
+
+    const EpisodeReport& first = rows.front();
+    const std::string meta = "run_id=" + first.runId + "\nagent_name=" + first.agentName +
+                             "\nmode_name=" + first.modeName + "\nagent_config=" + first.agentConfig + "\n";
+
+    std::size_t offset = kColumnarHeaderSize + columns.size() * kColumnarDirectoryEntrySize;
+    std::vector<std::uint64_t> columnOffsets;
+    for (const auto& column : columns) {
+        columnOffsets.push_back(offset);
+        offset = alignUp(offset + column.bytes.size());
+    }
+    const std::uint64_t metaOffset = offset;
+
+    std::vector<unsigned char> out;
+    out.insert(out.end(), kColumnarMagic.begin(), kColumnarMagic.end());
+    put(out, kColumnarVersion);
+    put(out, static_cast<std::uint32_t>(columns.size()));
+    put(out, static_cast<std::uint64_t>(rows.size()));
+    put(out, metaOffset);
+    put(out, static_cast<std::uint64_t>(meta.size()));
+    padTo(out, kColumnarHeaderSize);
+    for (std::size_t i = 0; i < columns.size(); ++i) {
+        const std::size_t entry = out.size();
+        const std::size_t nameLength = std::min(std::strlen(columns[i].name), kColumnNameSize - 1);
+        out.insert(out.end(), columns[i].name, columns[i].name + nameLength);
+        padTo(out, entry + kColumnNameSize);
+        put(out, columns[i].type);
+        put(out, columns[i].width);
+        put(out, columnOffsets[i]);
+        put(out, std::uint64_t{0});
+    }
+    for (std::size_t i = 0; i < columns.size(); ++i) {
+        padTo(out, columnOffsets[i]);
+        out.insert(out.end(), columns[i].bytes.begin(), columns[i].bytes.end());
+    }
+    padTo(out, metaOffset);
+    out.insert(out.end(), meta.begin(), meta.end());
+
+    std::filesystem::path path = csvPath;
+    path.replace_extension(".tcol");
+    std::filesystem::path tmpPath = path;
+    tmpPath += ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(out.data()), static_cast<std::streamsize>(out.size()));
+        if (!file) {
+            std::cerr << "Erro ao gravar arquivo colunar em " << tmpPath << '\n';
+            return;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) {
+        std::cerr << "Erro ao substituir arquivo colunar em " << path << ": " << ec.message() << '\n';
+    }
+}
+
+} // namespace tetris
@@ -13,6 +13,26 @@ void TetrisEnv::reset() {
     holdsUsed_ = 0;
 }
 
+void TetrisEnv::reset(std::uint32_t seed) {
+    game_.seed(seed);
+    game_.setFixedPieceStream(false);
+    reset();
+}
+
+void TetrisEnv::resetFixedStream(std::uint32_t seed) {
+    game_.seed(seed);
+    game_.setFixedPieceStream(true);
+    reset();
+}
+
+void TetrisEnv::resampleFrom(const TetrisEnv& source, std::uint32_t seed) {
+    game_.copySampledFrom(source.game_, seed);
+    totalLinesCleared_ = source.totalLinesCleared_;
+    turnNumber_ = source.turnNumber_;
+    holdsUsed_ = source.holdsUsed_;
+    queueSize_ = source.queueSize_;
+}
+
 StepResult TetrisEnv::step(const Action& action) {
     if (isGameOver()) {
         return StepResult{0, 0, 0, true};
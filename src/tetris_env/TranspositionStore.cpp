@@ -0,0 +1,388 @@
+#include "tetris_env/TranspositionStore.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace tetris_env {
+
+// Layout no disco (little-endian, como a maquina que gravou).
+struct TranspositionStore::Slot {
+    std::uint64_t hash = 0; // 0 = vazio
+    std::int32_t visits = 0;
+    std::uint32_t reserved = 0;
+    double totalValue = 0.0;
+};
+
+namespace {
+
+constexpr std::array<char, 8> kMagic{'T', 'E', 'T', 'R', 'I', 'S', 'T', 'T'};
+constexpr std::uint32_t kVersion = 1;
+
+struct Header {
+    std::array<char, 8> magic{};
+    std::uint32_t version = 0;
+    std::uint32_t slotSize = 0;
+    std::uint64_t capacity = 0; // potencia de 2
+    std::uint64_t count = 0;
+};
+
+std::uint64_t normalizeHash(std::uint64_t hash) {
+    return hash == 0 ? 1 : hash;
+}
+
+std::uint64_t capacityFor(std::size_t count) {
+    std::uint64_t capacity = 16;
+    while (capacity < static_cast<std::uint64_t>(count) * 2) {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+// Lock exclusivo de um arquivo de TT: mutex por caminho dentro do processo e, em POSIX, flock
+// no arquivo <path>.lock entre processos.
+class SaveLock {
+public:
+    explicit SaveLock(const std::filesystem::path& path) : guard_(mutexFor(path)) {
+#ifndef _WIN32
+        std::filesystem::path lockPath = path;
+        lockPath += ".lock";
+        fd_ = ::open(lockPath.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd_ >= 0) {
+            ::flock(fd_, LOCK_EX);
+        }
+#endif
+    }
+    ~SaveLock() {
+#ifndef _WIN32
+        if (fd_ >= 0) {
+            ::flock(fd_, LOCK_UN);
+            ::close(fd_);
+        }
+#endif
+    }
+    SaveLock(const SaveLock&) = delete;
+    SaveLock& operator=(const SaveLock&) = delete;
+
+private:
+    static std::mutex& mutexFor(const std::filesystem::path& path) {
+        static std::mutex registryMutex;
+        static std::map<std::string, std::unique_ptr<std::mutex>> mutexes;
+        std::lock_guard<std::mutex> lock(registryMutex);
+        auto& slot = mutexes[std::filesystem::absolute(path).lexically_normal().string()];
+        if (!slot) {
+            slot = std::make_unique<std::mutex>();
+        }
+        return *slot;
+    }
+
+    std::lock_guard<std::mutex> guard_;
+#ifndef _WIN32
+    int fd_ = -1;
+#endif
+};
+
+// Os slots de um arquivo aberto podem ser gravados por save() enquanto outras threads consultam
+// o mesmo mapeamento; cada campo e lido e gravado inteiro.
+template <typename T>
+T loadField(const T& field) {
+    return std::atomic_ref<T>(const_cast<T&>(field)).load(std::memory_order_relaxed);
+}
+
+template <typename T>
+void storeField(T& field, T value) {
+    std::atomic_ref<T>(field).store(value, std::memory_order_relaxed);
+}
+
+bool validHeader(const Header& header, std::size_t size, std::size_t slotSize) {
+    return size >= sizeof(Header) &&
+           header.magic == kMagic &&
+           header.version == kVersion &&
+           header.slotSize == slotSize &&
+           header.capacity > 0 &&
+           (header.capacity & (header.capacity - 1)) == 0 &&
+           size >= sizeof(Header) + header.capacity * slotSize;
+}
+
+} // namespace
+
+TranspositionStore::~TranspositionStore() {
+    close();
+}
+
+TranspositionStore::TranspositionStore(TranspositionStore&& other) noexcept {
+    *this = std::move(other);
+}
+
+TranspositionStore& TranspositionStore::operator=(TranspositionStore&& other) noexcept {
+    if (this != &other) {
+        close();
+        slots_ = other.slots_;
+        capacity_ = other.capacity_;
+        count_ = other.count_;
+        mapping_ = other.mapping_;
+        mappingSize_ = other.mappingSize_;
+        buffer_ = std::move(other.buffer_);
+        other.slots_ = nullptr;
+        other.capacity_ = 0;
+        other.count_ = 0;
+        other.mapping_ = nullptr;
+        other.mappingSize_ = 0;
+    }
+    return *this;
+}
+
+bool TranspositionStore::open(const std::filesystem::path& path) {
+    close();
+
+    const unsigned char* data = nullptr;
+    std::size_t size = 0;
+#ifndef _WIN32
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info {};
+    if (::fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(Header))) {
+        ::close(fd);
+        return false;
+    }
+    size = static_cast<std::size_t>(info.st_size);
+    void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+    mapping_ = mapped;
+    mappingSize_ = size;
+    data = static_cast<const unsigned char*>(mapped);
+#else
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    buffer_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    size = buffer_.size();
+    data = buffer_.data();
+#endif
+
+    Header header{};
+    if (size >= sizeof(Header)) {
+        std::memcpy(&header, data, sizeof(Header));
+    }
+    if (!validHeader(header, size, sizeof(Slot))) {
+        std::cerr << "Aviso: arquivo de TT invalido, ignorado: " << path << '\n';
+        close();
+        return false;
+    }
+
+    slots_ = reinterpret_cast<const Slot*>(data + sizeof(Header));
+    capacity_ = header.capacity;
+    count_ = static_cast<std::size_t>(header.count);
+    return true;
+}
+
+void TranspositionStore::close() {
+#ifndef _WIN32
+    if (mapping_ != nullptr) {
+        ::munmap(mapping_, mappingSize_);
+    }
+#endif
+    mapping_ = nullptr;
+    mappingSize_ = 0;
+    buffer_.clear();
+    slots_ = nullptr;
+    capacity_ = 0;
+    count_ = 0;
+}
+
+std::optional<TranspositionStore::Entry> TranspositionStore::find(std::uint64_t hash) const {
+    if (slots_ == nullptr) {
+        return std::nullopt;
+    }
+    const std::uint64_t target = normalizeHash(hash);
+    const std::uint64_t mask = capacity_ - 1;
+    const std::uint64_t window = std::min(kProbeWindow, capacity_);
+    for (std::uint64_t i = target & mask, probes = 0; probes < window; i = (i + 1) & mask, ++probes) {
+        const Slot& slot = slots_[i];
+        const std::uint64_t slotHash = loadField(slot.hash);
+        if (slotHash == 0) {
+            return std::nullopt;
+        }
+        if (slotHash == target) {
+            return Entry{loadField(slot.visits), loadField(slot.totalValue)};
+        }
+    }
+    return std::nullopt;
+}
+
+bool TranspositionStore::save(const std::filesystem::path& path,
+                              const std::vector<std::pair<std::uint64_t, Entry>>& deltas,
+                              std::size_t maxEntries) {
+    SaveLock lock(path);
+
+    // Cria o cabecalho de um arquivo novo ou valida o de um existente.
+    Header header{};
+    auto prepare = [&](std::size_t size) {
+        if (size == 0) {
+            header.magic = kMagic;
+            header.version = kVersion;
+            header.slotSize = sizeof(Slot);
+            header.capacity = capacityFor(maxEntries);
+            return true;
+        }
+        if (!validHeader(header, size, sizeof(Slot))) {
+            std::cerr << "Aviso: arquivo de TT invalido, nao atualizado: " << path << '\n';
+            return false;
+        }
+        return true;
+    };
+
+    auto merge = [&](Slot* slots) {
+        const std::uint64_t mask = header.capacity - 1;
+        const std::uint64_t window = std::min(kProbeWindow, header.capacity);
+        const std::uint64_t limit = std::min<std::uint64_t>(maxEntries, header.capacity / 2);
+        for (const auto& [hash, delta] : deltas) {
+            const std::uint64_t target = normalizeHash(hash);
+            const std::uint64_t home = target & mask;
+            Slot* found = nullptr;
+            Slot* empty = nullptr;
+            for (std::uint64_t probes = 0; probes < window; ++probes) {
+                Slot& slot = slots[(home + probes) & mask];
+                if (slot.hash == target) {
+                    found = &slot;
+                    break;
+                }
+                if (slot.hash == 0) {
+                    empty = &slot;
+                    break;
+                }
+            }
+            if (found != nullptr) {
+                storeField(found->visits, found->visits + delta.visits);
+                storeField(found->totalValue, found->totalValue + delta.totalValue);
+                continue;
+            }
+            if (delta.visits <= 0) {
+                continue;
+            }
+            if (empty != nullptr && header.count < limit) {
+                storeField(empty->visits, delta.visits);
+                storeField(empty->totalValue, delta.totalValue);
+                storeField(empty->hash, target);
+                ++header.count;
+                continue;
+            }
+
+            // Sem espaco: envelhece a janela e substitui a entrada menos visitada.
+            Slot* weakest = nullptr;
+            for (std::uint64_t probes = 0; probes < window; ++probes) {
+                Slot& slot = slots[(home + probes) & mask];
+                if (slot.hash == 0) {
+                    break;
+                }
+                const std::int32_t aged = slot.visits / 2;
+                storeField(slot.totalValue, slot.visits > 0 ? slot.totalValue * aged / slot.visits : 0.0);
+                storeField(slot.visits, aged);
+                if (weakest == nullptr || slot.visits < weakest->visits) {
+                    weakest = &slot;
+                }
+            }
+            if (weakest != nullptr && weakest->visits < delta.visits) {
+                storeField(weakest->visits, 0);
+                storeField(weakest->hash, target);
+                storeField(weakest->totalValue, delta.totalValue);
+                storeField(weakest->visits, delta.visits);
+            }
+        }
+    };
+
+#ifndef _WIN32
+    const int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        std::cerr << "Erro ao gravar TT em " << path << '\n';
+        return false;
+    }
+    struct stat info {};
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        return false;
+    }
+    std::size_t size = static_cast<std::size_t>(info.st_size);
+    if (size >= sizeof(Header) && ::pread(fd, &header, sizeof(Header), 0) != static_cast<ssize_t>(sizeof(Header))) {
+        ::close(fd);
+        return false;
+    }
+    if (!prepare(size)) {
+        ::close(fd);
+        return false;
+    }
+    if (size == 0) {
+        // Os slots vazios ficam como buracos no arquivo ate serem usados.
+        size = sizeof(Header) + header.capacity * sizeof(Slot);
+        if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            std::cerr << "Erro ao gravar TT em " << path << '\n';
+            ::close(fd);
+            return false;
+        }
+        if (::pwrite(fd, &header, sizeof(Header), 0) != static_cast<ssize_t>(sizeof(Header))) {
+            ::close(fd);
+            return false;
+        }
+    }
+    void* mapped = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Erro ao mapear TT em " << path << '\n';
+        return false;
+    }
+    auto* data = static_cast<unsigned char*>(mapped);
+    merge(reinterpret_cast<Slot*>(data + sizeof(Header)));
+    std::memcpy(data, &header, sizeof(Header));
+    ::munmap(mapped, size);
+    return true;
+#else
+    std::vector<unsigned char> buffer;
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (file.is_open()) {
+            buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+    }
+    if (buffer.size() >= sizeof(Header)) {
+        std::memcpy(&header, buffer.data(), sizeof(Header));
+    }
+    if (!prepare(buffer.size())) {
+        return false;
+    }
+    if (buffer.empty()) {
+        buffer.assign(sizeof(Header) + header.capacity * sizeof(Slot), 0);
+    }
+    merge(reinterpret_cast<Slot*>(buffer.data() + sizeof(Header)));
+    std::memcpy(buffer.data(), &header, sizeof(Header));
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+    if (!file) {
+        std::cerr << "Erro ao gravar TT em " << path << '\n';
+        return false;
+    }
+    return true;
+#endif
+}
+
+} // namespace tetris_env
@@ -0,0 +1,181 @@
+#include "tetris_env/TreeDump.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+
+namespace tetris_env::treedump {
+namespace {
+
+constexpr std::array<char, 8> kMagic{'T', 'E', 'T', 'R', 'T', 'R', 'E', 'E'};
+constexpr int kTargetXOffset = 3;
+
+template <typename T>
+void put(std::vector<unsigned char>& out, T value) {
+    const std::size_t offset = out.size();
+    out.resize(offset + sizeof(T));
+    std::memcpy(out.data() + offset, &value, sizeof(T));
+}
+
+template <typename T>
+bool get(std::istream& in, T& value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+} // namespace
+
+std::uint8_t packAction(const Action& action) {
+    const int column = std::clamp(action.targetX + kTargetXOffset, 0, 15);
+    return static_cast<std::uint8_t>((action.rotation & 3) | (action.useHold ? 4 : 0) | (column << 3));
+}
+
+Action unpackAction(std::uint8_t packed) {
+    Action action{};
+    action.rotation = packed & 3;
+    action.useHold = (packed & 4) != 0;
+    action.targetX = (packed >> 3) - kTargetXOffset;
+    return action;
+}
+
+void encodeMove(const MoveRecord& record, bool boards, std::vector<unsigned char>& out) {
+    put(out, record.episode);
+    put(out, record.move);
+    put(out, record.chosenAction);
+    put(out, static_cast<std::uint8_t>(record.workers.size()));
+    for (const auto& nodes : record.workers) {
+        put(out, static_cast<std::uint32_t>(nodes.size()));
+        for (const NodeRecord& node : nodes) {
+            put(out, node.action);
+            put(out, node.childCount);
+            put(out, node.visits);
+            put(out, node.meanValue);
+            if (boards) {
+                for (std::uint16_t row : node.board) {
+                    put(out, row);
+                }
+            }
+        }
+    }
+}
+
+bool readHeader(std::istream& in, std::uint32_t& flags) {
+    std::array<char, 8> magic{};
+    std::uint32_t version = 0;
+    if (!in.read(magic.data(), magic.size()) || magic != kMagic || !get(in, version) || version != kVersion) {
+        return false;
+    }
+    return get(in, flags);
+}
+
+bool readMove(std::istream& in, bool boards, MoveRecord& record) {
+    std::uint8_t workers = 0;
+    if (!get(in, record.episode) || !get(in, record.move) || !get(in, record.chosenAction) || !get(in, workers)) {
+        return false;
+    }
+    record.workers.assign(workers, {});
+    for (auto& nodes : record.workers) {
+        std::uint32_t count = 0;
+        if (!get(in, count)) {
+            return false;
+        }
+        nodes.resize(count);
+        for (NodeRecord& node : nodes) {
+            if (!get(in, node.action) || !get(in, node.childCount) || !get(in, node.visits) ||
+                !get(in, node.meanValue)) {
+                return false;
+            }
+            if (boards) {
+                for (std::uint16_t& row : node.board) {
+                    if (!get(in, row)) {
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+Writer::~Writer() {
+    close();
+}
+
+std::shared_ptr<Writer> Writer::shared(const std::filesystem::path& path, std::uint32_t flags) {
+    static std::mutex registryMutex;
+    static std::map<std::string, std::weak_ptr<Writer>> live;
+    static std::set<std::string> opened;
+
+    const std::string key = std::filesystem::absolute(path).lexically_normal().string();
+    std::lock_guard<std::mutex> lock(registryMutex);
+    if (auto existing = live[key].lock()) {
+        return existing;
+    }
+    auto writer = std::make_shared<Writer>();
+    if (!writer->open(path, flags, opened.count(key) > 0)) {
+        return nullptr;
+    }
+    opened.insert(key);
+    live[key] = writer;
+    return writer;
+}
+
+bool Writer::open(const std::filesystem::path& path, std::uint32_t flags, bool append) {
+    close();
+    file_.open(path, std::ios::binary | (append ? std::ios::app : std::ios::trunc));
+    if (!file_.is_open()) {
+        std::cerr << "Erro ao criar dump da arvore em " << path << '\n';
+        return false;
+    }
+    if (!append) {
+        file_.write(kMagic.data(), kMagic.size());
+        file_.write(reinterpret_cast<const char*>(&kVersion), sizeof(kVersion));
+        file_.write(reinterpret_cast<const char*>(&flags), sizeof(flags));
+    }
+    quit_ = false;
+    thread_ = std::thread([this]() { run(); });
+    return true;
+}
+
+void Writer::enqueue(std::vector<unsigned char> bytes) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(std::move(bytes));
+    }
+    wake_.notify_one();
+}
+
+void Writer::close() {
+    if (thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            quit_ = true;
+        }
+        wake_.notify_one();
+        thread_.join();
+    }
+    if (file_.is_open()) {
+        file_.close();
+    }
+}
+
+void Writer::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        wake_.wait(lock, [this]() { return quit_ || !queue_.empty(); });
+        if (queue_.empty()) {
+            file_.flush();
+            return; // quit_ com a fila vazia
+        }
+        std::vector<unsigned char> bytes = std::move(queue_.front());
+        queue_.pop_front();
+        lock.unlock();
+        file_.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        lock.lock();
+    }
+}
+
+} // namespace tetris_env::treedump
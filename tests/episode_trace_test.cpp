@@ -0,0 +1,151 @@
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "tetris_env/EpisodeTrace.hpp"
+#include "tetris_env/TetrisEnv.hpp"
+#include "tetris_env/TreeDump.hpp"
+
+namespace trace = tetris_env::trace;
+
+namespace {
+
+bool ok = true;
+
+void expect(bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << message << '\n';
+        ok = false;
+    }
+}
+
+bool sameStep(const trace::StepRecord& a, const trace::StepRecord& b, bool boardHash) {
+    return a.piece == b.piece && a.action == b.action && a.linesCleared == b.linesCleared &&
+           a.scoreDelta == b.scoreDelta && a.latencyUs == b.latencyUs && (!boardHash || a.boardHash == b.boardHash);
+}
+
+// Codifica e le de volta um episodio com valores nas bordas do formato.
+void roundTrip(bool boardHash) {
+    std::vector<trace::StepRecord> steps;
+    for (const int targetX : {-3, 0, 12}) {
+        for (const bool hold : {false, true}) {
+            trace::StepRecord step{};
+            step.piece = 6;
+            step.action = tetris_env::treedump::packAction(Action{3, targetX, hold});
+            step.linesCleared = 4;
+            step.boardHash = 0xDEADBEEFu;
+            steps.push_back(step);
+        }
+    }
+    // Varints de 1 a 5 bytes.
+    const std::vector<std::uint32_t> varints{0, 127, 128, 16383, 16384, 2097152, 0xFFFFFFFFu};
+    for (std::size_t i = 0; i < steps.size(); ++i) {
+        steps[i].scoreDelta = varints[i % varints.size()];
+        steps[i].latencyUs = varints[(i + 3) % varints.size()];
+    }
+
+    const std::uint32_t flags = (boardHash ? trace::kFlagBoardHash : 0u) | trace::kFlagFixedPieceStream;
+    std::vector<unsigned char> bytes;
+    trace::encodeHeader(flags, bytes);
+    trace::encodeEpisodeStart(0xFFFFFFFFu, 300, bytes);
+    for (const auto& step : steps) {
+        trace::encodeStep(step, boardHash, bytes);
+    }
+    trace::encodeEpisodeEnd(1u << 30, static_cast<std::uint32_t>(steps.size()), bytes);
+
+    std::istringstream in(std::string(bytes.begin(), bytes.end()));
+    std::uint32_t readFlags = 0;
+    trace::EpisodeRecord record;
+    expect(trace::readHeader(in, readFlags) && readFlags == flags, "flags do cabecalho diferentes");
+    expect(trace::readEpisode(in, boardHash, record), "episodio nao lido de volta");
+    expect(record.episode == 0xFFFFFFFFu && record.seed == 300 && record.finalScore == (1u << 30),
+           "episodio, seed ou score final diferentes");
+    expect(record.steps.size() == steps.size(), "quantidade de jogadas diferente");
+    for (std::size_t i = 0; i < steps.size() && i < record.steps.size(); ++i) {
+        expect(sameStep(steps[i], record.steps[i], boardHash), "jogada " + std::to_string(i) + " diferente");
+        const Action action = tetris_env::treedump::unpackAction(record.steps[i].action);
+        const Action original = tetris_env::treedump::unpackAction(steps[i].action);
+        expect(action.targetX == original.targetX && action.useHold == original.useHold && action.rotation == 3,
+               "acao da jogada " + std::to_string(i) + " diferente");
+    }
+    expect(tetris_env::treedump::unpackAction(record.steps.front().action).targetX == -3 &&
+               tetris_env::treedump::unpackAction(record.steps.back().action).targetX == 12,
+           "targetX extremo nao sobreviveu ao empacotamento");
+    expect(!trace::readEpisode(in, boardHash, record), "sobrou dado depois do episodio");
+}
+
+// Grava um episodio jogado (com hold) e o reproduz a partir do trace: as pecas, os hashes do
+// tabuleiro e o score final tem de bater.
+void replay(bool fixedStream) {
+    constexpr std::uint32_t kSeed = 11;
+    std::mt19937 rng(5);
+    TetrisEnv env;
+    fixedStream ? env.resetFixedStream(kSeed) : env.reset(kSeed);
+
+    std::vector<unsigned char> bytes;
+    trace::encodeHeader(trace::kFlagBoardHash | (fixedStream ? trace::kFlagFixedPieceStream : 0u), bytes);
+    trace::encodeEpisodeStart(1, kSeed, bytes);
+    std::uint32_t stepCount = 0;
+    int holds = 0;
+    while (!env.isGameOver() && stepCount < 300) {
+        const std::vector<Action> actions = env.getValidActions();
+        if (actions.empty()) {
+            break;
+        }
+        const Action action = actions[std::uniform_int_distribution<std::size_t>(0, actions.size() - 1)(rng)];
+        holds += action.useHold ? 1 : 0;
+        trace::StepRecord step{};
+        step.piece = static_cast<std::uint8_t>(env.getCurrentPieceType());
+        step.action = tetris_env::treedump::packAction(action);
+        const StepResult result = env.step(action);
+        step.linesCleared = static_cast<std::uint8_t>(result.linesCleared);
+        step.scoreDelta = static_cast<std::uint32_t>(result.scoreDelta);
+        step.boardHash = trace::hashBoard(tetris_env::bitboard::rowsFromBoard(env.getBoard()));
+        trace::encodeStep(step, true, bytes);
+        ++stepCount;
+        if (result.done) {
+            break;
+        }
+    }
+    trace::encodeEpisodeEnd(static_cast<std::uint32_t>(env.getScore()), stepCount, bytes);
+    expect(holds > 0, "o episodio gravado nao usou hold");
+
+    std::istringstream in(std::string(bytes.begin(), bytes.end()));
+    std::uint32_t flags = 0;
+    trace::EpisodeRecord record;
+    expect(trace::readHeader(in, flags) && trace::readEpisode(in, true, record), "trace gravado nao lido");
+
+    TetrisEnv replayed;
+    (flags & trace::kFlagFixedPieceStream) != 0 ? replayed.resetFixedStream(record.seed) : replayed.reset(record.seed);
+    for (std::size_t i = 0; i < record.steps.size(); ++i) {
+        const trace::StepRecord& step = record.steps[i];
+        if (static_cast<std::uint8_t>(replayed.getCurrentPieceType()) != step.piece) {
+            expect(false, "peca diferente na jogada " + std::to_string(i));
+            return;
+        }
+        replayed.step(tetris_env::treedump::unpackAction(step.action));
+        if (trace::hashBoard(tetris_env::bitboard::rowsFromBoard(replayed.getBoard())) != step.boardHash) {
+            expect(false, "tabuleiro diferente depois da jogada " + std::to_string(i));
+            return;
+        }
+    }
+    expect(static_cast<std::uint32_t>(replayed.getScore()) == record.finalScore,
+           std::string("score final da reproducao diferente") + (fixedStream ? " (sequencia fixa)" : ""));
+}
+
+} // namespace
+
+int main() {
+    roundTrip(false);
+    roundTrip(true);
+    replay(false);
+    replay(true);
+    if (!ok) {
+        return EXIT_FAILURE;
+    }
+    std::cout << "ok: trace codificado, lido e reproduzido\n";
+    return EXIT_SUCCESS;
+}
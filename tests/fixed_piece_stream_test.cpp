@@ -0,0 +1,66 @@
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "tetris_env/GreedyAgent.hpp"
+#include "tetris_env/TetrisEnv.hpp"
+
+namespace {
+
+// Pecas que entram no fim da fila visivel, em ordem, jogando o Greedy; com holdEvery > 0 a cada
+// holdEvery jogadas usa a melhor jogada com hold no lugar.
+std::vector<tetris_env::PieceType> pieceStream(std::uint32_t seed, int holdEvery, int& holds) {
+    GreedyAgent agent;
+    TetrisEnv env;
+    env.resetFixedStream(seed);
+    std::vector<tetris_env::PieceType> stream = env.getNextQueue();
+    holds = 0;
+    for (int move = 1; move <= 200 && !env.isGameOver(); ++move) {
+        Action action = agent.chooseAction(env);
+        if (holdEvery > 0 && move % holdEvery == 0 && !action.useHold) {
+            for (const Action& candidate : env.getValidActions()) {
+                if (candidate.useHold) {
+                    action = candidate;
+                    break;
+                }
+            }
+        }
+        holds += action.useHold ? 1 : 0;
+        if (env.step(action).done) {
+            break;
+        }
+        const std::vector<tetris_env::PieceType> queue = env.getNextQueue();
+        if (!queue.empty()) {
+            stream.push_back(queue.back());
+        }
+    }
+    return stream;
+}
+
+} // namespace
+
+// Com resetFixedStream, agentes que usam o hold de formas diferentes recebem as mesmas pecas.
+// Sem a sequencia fixa, a primeira troca diferente com o hold muda as pecas seguintes.
+int main() {
+    int holdsA = 0;
+    int holdsB = 0;
+    const std::vector<tetris_env::PieceType> a = pieceStream(21, 0, holdsA);
+    const std::vector<tetris_env::PieceType> b = pieceStream(21, 3, holdsB);
+    if (holdsA == holdsB) {
+        std::cerr << "os dois agentes usaram o hold igual; o teste nao exercita a troca\n";
+        return EXIT_FAILURE;
+    }
+    const std::size_t common = std::min(a.size(), b.size());
+    if (common < 20) {
+        std::cerr << "episodios curtos demais (" << common << " pecas)\n";
+        return EXIT_FAILURE;
+    }
+    for (std::size_t i = 0; i < common; ++i) {
+        if (a[i] != b[i]) {
+            std::cerr << "peca " << i + 1 << " diferente entre os agentes\n";
+            return EXIT_FAILURE;
+        }
+    }
+    std::cout << "ok: " << common << " pecas iguais com " << holdsA << " e " << holdsB << " hold(s)\n";
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,63 @@
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "tetris_env/MctsRolloutAgent.hpp"
+#include "tetris_env/TetrisEnv.hpp"
+
+namespace {
+
+struct EpisodeResult {
+    std::vector<Action> actions;
+    int score = 0;
+};
+
+EpisodeResult playEpisode(const MctsParams& params) {
+    MctsRolloutAgent agent(params);
+    TetrisEnv env;
+    env.reset(17);
+    agent.onEpisodeStart();
+    EpisodeResult result;
+    for (int move = 0; move < 20 && !env.isGameOver(); ++move) {
+        const Action action = agent.chooseAction(env);
+        result.actions.push_back(action);
+        if (env.step(action).done) {
+            break;
+        }
+    }
+    agent.onEpisodeEnd();
+    result.score = env.getScore();
+    return result;
+}
+
+} // namespace
+
+// Com deterministic, duas execucoes com TT e 2 threads de busca jogam as mesmas jogadas.
+int main() {
+    MctsParams params;
+    params.iterations = 400;
+    params.maxDepth = 8;
+    params.exploration = 1.4142;
+    params.threads = 2;
+    params.seed = 3;
+    params.deterministic = true;
+    params.useTranspositionTable = true;
+
+    const EpisodeResult first = playEpisode(params);
+    const EpisodeResult second = playEpisode(params);
+    if (first.actions.size() != second.actions.size() || first.score != second.score) {
+        std::cerr << "execucoes diferentes: " << first.actions.size() << " jogadas e score " << first.score
+                  << " contra " << second.actions.size() << " jogadas e score " << second.score << '\n';
+        return EXIT_FAILURE;
+    }
+    for (std::size_t i = 0; i < first.actions.size(); ++i) {
+        const Action& a = first.actions[i];
+        const Action& b = second.actions[i];
+        if (a.rotation != b.rotation || a.targetX != b.targetX || a.useHold != b.useHold) {
+            std::cerr << "jogada " << i + 1 << " diferente entre as execucoes\n";
+            return EXIT_FAILURE;
+        }
+    }
+    std::cout << "ok: " << first.actions.size() << " jogadas iguais, score " << first.score << '\n';
+    return EXIT_SUCCESS;
+}
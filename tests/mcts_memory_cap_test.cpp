@@ -0,0 +1,43 @@
+#include <cstdlib>
+#include <iostream>
+
+#include "tetris_env/MctsRolloutAgent.hpp"
+#include "tetris_env/TetrisEnv.hpp"
+
+// O pico de memoria estimado da arvore nao passa de node_memory_mb com a TT ligada, contando a
+// chave de estado de cada no e a capacidade dos vetores.
+int main() {
+    MctsParams params;
+    params.iterations = 5000;
+    params.maxDepth = 10;
+    params.exploration = 1.4142;
+    params.threads = 1;
+    params.seed = 1;
+    params.useTranspositionTable = true;
+    params.nodeMemoryMb = 0.25;
+    const std::size_t capBytes = static_cast<std::size_t>(params.nodeMemoryMb * 1024.0 * 1024.0);
+
+    MctsRolloutAgent agent(params);
+    TetrisEnv env;
+    env.reset(7);
+    agent.onEpisodeStart();
+
+    int pruned = 0;
+    for (int move = 0; move < 3 && !env.isGameOver(); ++move) {
+        const Action action = agent.chooseAction(env);
+        const MctsMoveStats& stats = agent.lastMoveStats();
+        pruned += stats.prunedNodes;
+        if (stats.peakNodeBytes > capBytes) {
+            std::cerr << "jogada " << move + 1 << ": pico de " << stats.peakNodeBytes << " bytes passa do teto de "
+                      << capBytes << '\n';
+            return EXIT_FAILURE;
+        }
+        env.step(action);
+    }
+    if (pruned == 0) {
+        std::cerr << "o teto nunca foi atingido; o teste nao exercita a poda\n";
+        return EXIT_FAILURE;
+    }
+    std::cout << "ok: " << pruned << " no(s) podado(s) sem passar de " << capBytes << " bytes\n";
+    return EXIT_SUCCESS;
+}
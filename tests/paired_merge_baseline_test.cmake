@@ -0,0 +1,46 @@
+# O --merge de shards compara cada agente com o mesmo baseline que o batch sem shards.
+# Uso: cmake -DRUNNER=<tetris_batch_runner> -DWORK_DIR=<dir> -P paired_merge_baseline_test.cmake
+
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+file(WRITE "${WORK_DIR}/batch.yaml" "threads: 2
+calibration_seconds: 0
+paired_seed: 100
+agents:
+  - name: r1
+    type: random
+    episodes: 4
+  - name: r2
+    type: random
+    episodes: 4
+  - name: r3
+    type: random
+    episodes: 4
+    baseline: r2
+")
+
+function(run_batch out_var)
+  execute_process(COMMAND "${RUNNER}" batch.yaml ${ARGN}
+                  WORKING_DIRECTORY "${WORK_DIR}"
+                  RESULT_VARIABLE result
+                  OUTPUT_VARIABLE output
+                  ERROR_VARIABLE output)
+  if(NOT result EQUAL 0)
+    message(FATAL_ERROR "tetris_batch_runner ${ARGN} falhou (${result}):\n${output}")
+  endif()
+  string(REGEX MATCHALL "\\[Pareado\\] [^:]+:" pairs "${output}")
+  set(${out_var} "${pairs}" PARENT_SCOPE)
+endfunction()
+
+run_batch(unsharded --run-id inteiro)
+run_batch(shard1 --run-id shards --shard 1/2)
+run_batch(shard2 --run-id shards --shard 2/2)
+run_batch(merged --merge shards)
+
+if(NOT unsharded MATCHES "r3 - r2")
+  message(FATAL_ERROR "batch sem shards nao comparou r3 com o baseline r2: ${unsharded}")
+endif()
+if(NOT merged STREQUAL unsharded)
+  message(FATAL_ERROR "comparacoes do --merge (${merged}) diferem das do batch sem shards (${unsharded})")
+endif()
+file(REMOVE_RECURSE "${WORK_DIR}")
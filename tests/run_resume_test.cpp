@@ -0,0 +1,163 @@
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "tetris_env/EpisodeTrace.hpp"
+#include "tetris_env/RunLogging.hpp"
+#include "tetris_env/RunResume.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+tetris::EpisodeReport report(int episode) {
+    tetris::EpisodeReport rep{};
+    rep.agentName = "a";
+    rep.modeName = "mcts_rollout";
+    rep.runId = "teste";
+    rep.episodeIndex = episode;
+    rep.score = 100 * episode;
+    rep.totalTurns = 10 + episode;
+    return rep;
+}
+
+void appendTraceEpisode(int episode, std::vector<unsigned char>& out) {
+    tetris_env::trace::encodeEpisodeStart(static_cast<std::uint32_t>(episode), 42, out);
+    for (int i = 0; i < 3; ++i) {
+        tetris_env::trace::StepRecord step{};
+        step.piece = static_cast<std::uint8_t>(i);
+        step.scoreDelta = 10;
+        step.latencyUs = 300;
+        tetris_env::trace::encodeStep(step, false, out);
+    }
+    tetris_env::trace::encodeEpisodeEnd(30, 3, out);
+}
+
+void writeFile(const fs::path& path, const std::string& content) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << content;
+}
+
+std::string readFile(const fs::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream raw;
+    raw << in.rdbuf();
+    return raw.str();
+}
+
+} // namespace
+
+// Retomada de um batch interrompido no meio da escrita: CSV, telemetria e trace terminam num
+// registro cortado. So os episodios com linha completa no CSV ficam nos tres arquivos e os demais
+// voltam para a fila.
+int main() {
+    const fs::path dir = fs::temp_directory_path() / "tetris_run_resume_test";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    const fs::path csvPath = dir / "run.csv";
+    const fs::path telemetryPath = dir / "run_telemetry.jsonl";
+    const fs::path tracePath = dir / "run.ttrace";
+    constexpr int kEpisodes = 6;
+
+    // CSV: episodios 1, 3 e 2, o 3 repetido e o 4 cortado.
+    std::string csv = tetris::kEpisodeCsvHeader;
+    for (const int episode : {1, 3, 2, 3, 4}) {
+        tetris::formatEpisodeCsvRow(report(episode), csv);
+    }
+    csv.resize(csv.size() - 20);
+    writeFile(csvPath, csv);
+
+    // Telemetria: episodios 1 a 5, o 5 cortado no meio da linha.
+    std::string telemetry;
+    std::vector<MctsMoveStats> moves(2);
+    for (int episode = 1; episode <= 5; ++episode) {
+        tetris::formatMoveTelemetryJsonl("teste", episode, moves, telemetry);
+    }
+    telemetry.resize(telemetry.size() - 10);
+    writeFile(telemetryPath, telemetry);
+
+    // Trace: episodios 1, 4, 3 e 2, o 2 cortado.
+    std::vector<unsigned char> trace;
+    tetris_env::trace::encodeHeader(0, trace);
+    for (const int episode : {1, 4, 3, 2}) {
+        appendTraceEpisode(episode, trace);
+    }
+    trace.resize(trace.size() - 3);
+    writeFile(tracePath, std::string(trace.begin(), trace.end()));
+
+    tetris::ResumedRunFiles resumed;
+    if (!tetris::resumeRunFiles(csvPath, telemetryPath, tracePath, kEpisodes, resumed)) {
+        std::cerr << "resumeRunFiles falhou\n";
+        return EXIT_FAILURE;
+    }
+
+    bool ok = true;
+    auto expect = [&](bool condition, const std::string& message) {
+        if (!condition) {
+            std::cerr << message << '\n';
+            ok = false;
+        }
+    };
+
+    const std::set<int> completed{1, 2, 3};
+    for (int episode = 1; episode <= kEpisodes; ++episode) {
+        const auto& rep = resumed.reports[static_cast<std::size_t>(episode - 1)];
+        expect(rep.has_value() == (completed.count(episode) > 0),
+               "episodio " + std::to_string(episode) + " mantido/descartado errado");
+        if (rep.has_value()) {
+            expect(rep->score == 100 * episode, "score do episodio " + std::to_string(episode) + " errado");
+        }
+    }
+    expect(resumed.missingEpisodes == std::vector<int>{4, 5, 6}, "episodios a refazer diferentes de 4, 5, 6");
+    expect(resumed.droppedRows == 2, "esperadas 2 linhas descartadas do CSV (repetida e cortada)");
+
+    std::set<int> csvEpisodes;
+    std::istringstream csvIn(readFile(csvPath));
+    std::string line;
+    std::getline(csvIn, line);
+    expect(line + '\n' == tetris::kEpisodeCsvHeader, "cabecalho do CSV perdido");
+    while (std::getline(csvIn, line)) {
+        tetris::EpisodeReport rep{};
+        expect(tetris::parseEpisodeCsvRow(line, rep), "linha invalida no CSV regravado: " + line);
+        expect(csvEpisodes.insert(rep.episodeIndex).second, "episodio repetido no CSV regravado");
+    }
+    expect(csvEpisodes == completed, "CSV regravado com episodios errados");
+
+    std::set<int> telemetryEpisodes;
+    std::istringstream telemetryIn(readFile(telemetryPath));
+    int telemetryLines = 0;
+    while (std::getline(telemetryIn, line)) {
+        ++telemetryLines;
+        expect(!line.empty() && line.back() == '}', "linha cortada na telemetria: " + line);
+        const std::size_t pos = line.find("\"episode\":");
+        if (pos != std::string::npos) {
+            telemetryEpisodes.insert(std::atoi(line.c_str() + pos + 10));
+        }
+    }
+    expect(telemetryEpisodes == completed, "telemetria com episodios errados");
+    expect(telemetryLines == 2 * static_cast<int>(completed.size()), "telemetria perdeu jogadas dos episodios mantidos");
+
+    std::istringstream traceIn(readFile(tracePath));
+    std::uint32_t flags = 0;
+    expect(tetris_env::trace::readHeader(traceIn, flags), "cabecalho do trace perdido");
+    std::vector<int> traceEpisodes;
+    tetris_env::trace::EpisodeRecord record;
+    while (tetris_env::trace::readEpisode(traceIn, false, record)) {
+        expect(record.steps.size() == 3 && record.finalScore == 30, "registro do trace alterado");
+        traceEpisodes.push_back(static_cast<int>(record.episode));
+    }
+    expect(traceIn.eof(), "sobrou um registro cortado no trace");
+    expect(traceEpisodes == std::vector<int>{1, 3}, "trace com episodios errados");
+
+    fs::remove_all(dir);
+    if (!ok) {
+        return EXIT_FAILURE;
+    }
+    std::cout << "ok: episodios 1-3 mantidos, 4-6 voltam para a fila\n";
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,118 @@
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "tetris_env/TreeDump.hpp"
+
+namespace treedump = tetris_env::treedump;
+
+namespace {
+
+bool ok = true;
+
+void expect(bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << message << '\n';
+        ok = false;
+    }
+}
+
+treedump::MoveRecord sampleMove(std::uint32_t episode) {
+    treedump::MoveRecord record;
+    record.episode = episode;
+    record.move = 70000; // alem de 16 bits
+    record.chosenAction = treedump::packAction(Action{2, 12, true});
+    for (int worker = 0; worker < 2; ++worker) {
+        std::vector<treedump::NodeRecord> nodes(3);
+        nodes[0].childCount = 2;
+        nodes[0].visits = 0xFFFFFFFFu;
+        nodes[0].meanValue = -1.5f;
+        nodes[1].action = treedump::packAction(Action{0, -3, false});
+        nodes[1].visits = 1;
+        nodes[1].meanValue = 1e6f;
+        nodes[2].action = treedump::packAction(Action{1, 4, true});
+        nodes[2].visits = 128;
+        for (std::size_t row = 0; row < nodes[2].board.size(); ++row) {
+            nodes[2].board[row] = static_cast<std::uint16_t>(0x3FF >> (row % 10));
+        }
+        record.workers.push_back(nodes);
+    }
+    return record;
+}
+
+// Grava dois registros pelo Writer e le de volta, com e sem os tabuleiros nos nos.
+void roundTrip(bool boards) {
+    const std::filesystem::path path = std::filesystem::temp_directory_path() /
+                                       (boards ? "tetris_tree_dump_test_boards.bin" : "tetris_tree_dump_test.bin");
+    const std::vector<treedump::MoveRecord> moves{sampleMove(1), sampleMove(2)};
+    {
+        treedump::Writer writer;
+        expect(writer.open(path, boards ? treedump::kFlagBoards : 0u), "nao abriu o dump para gravar");
+        for (const auto& move : moves) {
+            std::vector<unsigned char> bytes;
+            treedump::encodeMove(move, boards, bytes);
+            writer.enqueue(std::move(bytes));
+        }
+        writer.close();
+    }
+
+    std::ifstream in(path, std::ios::binary);
+    std::uint32_t flags = 0;
+    expect(treedump::readHeader(in, flags) && flags == (boards ? treedump::kFlagBoards : 0u),
+           "flags do cabecalho diferentes");
+    for (const auto& expected : moves) {
+        treedump::MoveRecord record;
+        if (!treedump::readMove(in, (flags & treedump::kFlagBoards) != 0, record)) {
+            expect(false, "registro nao lido de volta");
+            return;
+        }
+        expect(record.episode == expected.episode && record.move == expected.move &&
+                   record.chosenAction == expected.chosenAction && record.workers.size() == expected.workers.size(),
+               "cabecalho do registro diferente");
+        for (std::size_t w = 0; w < expected.workers.size() && w < record.workers.size(); ++w) {
+            expect(record.workers[w].size() == expected.workers[w].size(), "quantidade de nos diferente");
+            for (std::size_t i = 0; i < expected.workers[w].size() && i < record.workers[w].size(); ++i) {
+                const treedump::NodeRecord& a = record.workers[w][i];
+                const treedump::NodeRecord& b = expected.workers[w][i];
+                expect(a.action == b.action && a.childCount == b.childCount && a.visits == b.visits &&
+                           a.meanValue == b.meanValue,
+                       "no " + std::to_string(i) + " diferente");
+                if (boards) {
+                    expect(a.board == b.board, "tabuleiro do no " + std::to_string(i) + " diferente");
+                }
+            }
+        }
+    }
+    treedump::MoveRecord extra;
+    expect(!treedump::readMove(in, boards, extra), "sobrou registro no dump");
+    in.close();
+    std::filesystem::remove(path);
+}
+
+} // namespace
+
+int main() {
+    // Todas as jogadas empacotadas voltam iguais, inclusive targetX nos extremos (-3 e 12).
+    for (int rotation = 0; rotation < 4; ++rotation) {
+        for (int targetX = -3; targetX <= 12; ++targetX) {
+            for (const bool hold : {false, true}) {
+                const std::uint8_t packed = treedump::packAction(Action{rotation, targetX, hold});
+                const Action action = treedump::unpackAction(packed);
+                expect(packed != treedump::kNoAction && action.rotation == rotation && action.targetX == targetX &&
+                           action.useHold == hold,
+                       "acao (" + std::to_string(rotation) + ", " + std::to_string(targetX) + ", " +
+                           std::to_string(hold) + ") nao sobreviveu ao empacotamento");
+            }
+        }
+    }
+    roundTrip(false);
+    roundTrip(true);
+    if (!ok) {
+        return EXIT_FAILURE;
+    }
+    std::cout << "ok: dump de arvore codificado e lido de volta\n";
+    return EXIT_SUCCESS;
+}